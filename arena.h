@@ -0,0 +1,110 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for trees that die all at once. Allocation is a pointer
+// bump inside the current chunk, and nothing is freed one object at a time:
+// reset() drops the whole tree by rewinding, so only types with trivial
+// destructors may live here. Not thread safe.
+class Arena {
+private:
+    static const size_t FIRST_CHUNK_SIZE = 64 * 1024;
+    static const size_t MAX_CHUNK_SIZE = 1024 * 1024;
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t current;    // chunk being bumped
+    char* next;        // first free byte in chunks[current]
+    char* limit;       // end of chunks[current]
+    size_t bytesUsed;  // handed out since the last reset, for stats
+
+    void useChunk(size_t index) {
+        current = index;
+        next = chunks[index].data.get();
+        limit = next + chunks[index].size;
+    }
+
+    // Slow path: move to the next chunk that fits, allocating one if needed
+    void* allocateSlow(size_t size, size_t align) {
+        size_t need = size + align;
+        for (size_t i = current + 1; i < chunks.size(); i++) {
+            if (chunks[i].size >= need) {
+                // Keep the chunks in use contiguous so reset() can rewind
+                std::swap(chunks[i], chunks[current + 1]);
+                useChunk(current + 1);
+                return allocate(size, align);
+            }
+        }
+        size_t chunkSize = chunks.empty() ? FIRST_CHUNK_SIZE : chunks.back().size * 2;
+        if (chunkSize > MAX_CHUNK_SIZE) chunkSize = MAX_CHUNK_SIZE;
+        if (chunkSize < need) chunkSize = need;
+        Chunk chunk;
+        chunk.data.reset(new char[chunkSize]);
+        chunk.size = chunkSize;
+        size_t at = chunks.empty() ? 0 : current + 1;
+        chunks.insert(chunks.begin() + at, std::move(chunk));
+        useChunk(at);
+        return allocate(size, align);
+    }
+
+public:
+    Arena() : current(0), next(nullptr), limit(nullptr), bytesUsed(0) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(next) + align - 1) & ~(uintptr_t)(align - 1);
+        if (next == nullptr || p + size > reinterpret_cast<uintptr_t>(limit)) {
+            return allocateSlow(size, align);
+        }
+        next = reinterpret_cast<char*>(p + size);
+        bytesUsed += size;
+        return reinterpret_cast<void*>(p);
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "arena objects are never destroyed one by one");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Uninitialized array of n pointers/PODs
+    template <typename T>
+    T* makeArray(size_t n) {
+        static_assert(std::is_trivial<T>::value, "arena arrays hold trivial types only");
+        return static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    // Drop everything allocated so far. The chunks are kept for the next
+    // parse, so a long-running process stops calling malloc once warm.
+    void reset() {
+        bytesUsed = 0;
+        if (chunks.empty()) return;
+        useChunk(0);
+    }
+
+    // Give the memory back to the system as well
+    void release() {
+        chunks.clear();
+        current = 0;
+        next = limit = nullptr;
+        bytesUsed = 0;
+    }
+
+    size_t bytesAllocated() const { return bytesUsed; }
+};
+
+#endif
@@ -0,0 +1,446 @@
+#ifndef AST_H
+#define AST_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "interner.h"
+#include "token.h"
+
+// What an AST node is. Dispatch is a switch on this, never a string compare.
+enum class ASTKind : uint8_t {
+    PROGRAM, BLOCK, DECLARATION, TYPE,
+    ASSIGN, IF, WHILE, DO_WHILE, RETURN, BREAK,
+    BINARY_OP, UNARY_OP, INDEX, IDENTIFIER, INTEGER, REAL
+};
+
+enum class BinaryOp : uint8_t {
+    OR, AND, EQUAL, NOT_EQUAL, LESS, LESS_EQ, GREATER, GREATER_EQ,
+    ADD, SUBTRACT, MULTIPLY, DIVIDE
+};
+
+enum class UnaryOp : uint8_t { NOT, NEGATE };
+
+// Types of variables and expressions, worked out by SemanticAnalyzer::resolve.
+// char and int do arithmetic as int, like C; anything with a float in it is float.
+enum class ValueType : uint8_t { UNKNOWN, INT, FLOAT, CHAR, VOID };
+
+inline const char* valueTypeName(ValueType type) {
+    switch (type) {
+        case ValueType::INT: return "int";
+        case ValueType::FLOAT: return "float";
+        case ValueType::CHAR: return "char";
+        case ValueType::VOID: return "void";
+        default: return "unknown";
+    }
+}
+
+inline const char* astKindName(ASTKind kind) {
+    static const char* const names[] = {
+        "Program", "Block", "Declaration", "Type",
+        "Assign", "If", "While", "DoWhile", "Return", "Break",
+        "BinaryOp", "UnaryOp", "Index", "Identifier", "Integer", "Real"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == (size_t)ASTKind::REAL + 1,
+                  "names out of sync with ASTKind");
+    return names[(size_t)kind];
+}
+
+inline const char* binaryOpText(BinaryOp op) {
+    static const char* const text[] = {
+        "||", "&&", "==", "!=", "<", "<=", ">", ">=", "+", "-", "*", "/"
+    };
+    return text[(size_t)op];
+}
+
+inline const char* unaryOpText(UnaryOp op) {
+    return op == UnaryOp::NOT ? "!" : "-";
+}
+
+// Operator token -> operator, the parser only calls these on operator tokens
+inline BinaryOp binaryOpFor(TokenType type) {
+    switch (type) {
+        case LOGIC_OR: return BinaryOp::OR;
+        case LOGIC_AND: return BinaryOp::AND;
+        case LOGIC_EQUAL: return BinaryOp::EQUAL;
+        case LOGIC_NOT_EQUAL: return BinaryOp::NOT_EQUAL;
+        case LESS_THAN: return BinaryOp::LESS;
+        case LESS_THAN_EQ: return BinaryOp::LESS_EQ;
+        case GREATER_THAN: return BinaryOp::GREATER;
+        case GREATER_THAN_EQ: return BinaryOp::GREATER_EQ;
+        case PLUS: return BinaryOp::ADD;
+        case MINUS: return BinaryOp::SUBTRACT;
+        case MULTIPLY: return BinaryOp::MULTIPLY;
+        default: return BinaryOp::DIVIDE;
+    }
+}
+
+inline UnaryOp unaryOpFor(TokenType type) {
+    return type == LOGIC_NOT ? UnaryOp::NOT : UnaryOp::NEGATE;
+}
+
+// AST Node for Abstract Syntax Tree. Every node keeps its children in one
+// vector so generic walks (printing, flattening, freeing) don't care about
+// the kind; the subclasses below add the typed payload and name the
+// children. Use astCast to get from ASTNode* to the subclass.
+class ASTNode {
+public:
+    ASTKind kind;
+    Symbol value;              // name, literal digits or operator text, EMPTY_SYMBOL if none
+    uint32_t id;               // preorder number from SemanticAnalyzer::resolve, same as the FlatTree index
+    uint32_t position;         // packed line/column of the node's token (Token::position), 0 if unknown
+    std::vector<ASTNode*> children;
+
+    ASTNode(ASTKind kind, Symbol val = EMPTY_SYMBOL) : kind(kind), value(val), id(0), position(0) {}
+
+    uint32_t line() const { return position >> TOKEN_COLUMN_BITS; }
+    uint32_t column() const { return position & TOKEN_MAX_COLUMN; }
+
+    // Add a child node
+    void addChild(ASTNode* child) {
+        if (child != nullptr) {
+            children.push_back(child);
+        }
+    }
+
+    ASTNode* child(size_t i) const {
+        return i < children.size() ? children[i] : nullptr;
+    }
+
+    // Print the tree, kinda ugly but works
+    void printTree(int depth = 0) const {
+        std::vector<std::pair<const ASTNode*, int>> stack;
+        stack.push_back(std::make_pair(this, depth));
+        while (!stack.empty()) {
+            const ASTNode* node = stack.back().first;
+            int nodeDepth = stack.back().second;
+            stack.pop_back();
+
+            std::string indent(nodeDepth * 2, ' ');
+            std::cout << indent << astKindName(node->kind);
+            if (node->value != EMPTY_SYMBOL) {
+                std::cout << " (" << symbolText(node->value) << ")";
+            }
+            std::cout << std::endl;
+            for (size_t i = node->children.size(); i-- > 0;) {
+                if (node->children[i] != nullptr) {
+                    stack.push_back(std::make_pair(node->children[i], nodeDepth + 1));
+                }
+            }
+        }
+    }
+
+    // Destructor to clean up. Children are detached and deleted from a
+    // worklist, so deleting a deep tree doesn't recurse.
+    virtual ~ASTNode() {
+        std::vector<ASTNode*> pending;
+        pending.swap(children);
+        while (!pending.empty()) {
+            ASTNode* node = pending.back();
+            pending.pop_back();
+            if (node == nullptr) continue;
+            pending.insert(pending.end(), node->children.begin(), node->children.end());
+            node->children.clear();
+            delete node;
+        }
+    }
+};
+
+// Typed nodes. KIND ties each class to its ASTKind for astCast.
+
+// Program [Block]
+struct ProgramNode : ASTNode {
+    static const ASTKind KIND = ASTKind::PROGRAM;
+    ProgramNode() : ASTNode(KIND) {}
+    ASTNode* block() const { return child(0); }
+};
+
+// Block [Declaration..., statements...]
+struct BlockNode : ASTNode {
+    static const ASTKind KIND = ASTKind::BLOCK;
+    BlockNode() : ASTNode(KIND) {}
+};
+
+// Type (int/float/char) [Integer...], one Integer per array dimension
+struct TypeNode : ASTNode {
+    static const ASTKind KIND = ASTKind::TYPE;
+    explicit TypeNode(Symbol basic) : ASTNode(KIND, basic) {}
+    Symbol basic() const { return value; }
+    size_t dimensionCount() const { return children.size(); }
+};
+
+// Declaration (name) [Type]
+struct DeclarationNode : ASTNode {
+    static const ASTKind KIND = ASTKind::DECLARATION;
+    explicit DeclarationNode(Symbol name) : ASTNode(KIND, name) {}
+    Symbol name() const { return value; }
+    TypeNode* type() const { return static_cast<TypeNode*>(child(0)); }
+};
+
+// Assign [Identifier or Index, value]
+struct AssignNode : ASTNode {
+    static const ASTKind KIND = ASTKind::ASSIGN;
+    AssignNode() : ASTNode(KIND) {}
+    ASTNode* target() const { return child(0); }
+    ASTNode* expression() const { return child(1); }
+};
+
+// If [condition, then, else?]
+struct IfNode : ASTNode {
+    static const ASTKind KIND = ASTKind::IF;
+    IfNode() : ASTNode(KIND) {}
+    ASTNode* condition() const { return child(0); }
+    ASTNode* thenStmt() const { return child(1); }
+    ASTNode* elseStmt() const { return child(2); }
+};
+
+// While [condition, body]
+struct WhileNode : ASTNode {
+    static const ASTKind KIND = ASTKind::WHILE;
+    WhileNode() : ASTNode(KIND) {}
+    ASTNode* condition() const { return child(0); }
+    ASTNode* body() const { return child(1); }
+};
+
+// DoWhile [body, condition]
+struct DoWhileNode : ASTNode {
+    static const ASTKind KIND = ASTKind::DO_WHILE;
+    DoWhileNode() : ASTNode(KIND) {}
+    ASTNode* body() const { return child(0); }
+    ASTNode* condition() const { return child(1); }
+};
+
+// Return [Integer]
+struct ReturnNode : ASTNode {
+    static const ASTKind KIND = ASTKind::RETURN;
+    ReturnNode() : ASTNode(KIND) {}
+    ASTNode* expression() const { return child(0); }
+};
+
+struct BreakNode : ASTNode {
+    static const ASTKind KIND = ASTKind::BREAK;
+    BreakNode() : ASTNode(KIND) {}
+};
+
+// BinaryOp (op) [left, right]
+struct BinaryOpNode : ASTNode {
+    static const ASTKind KIND = ASTKind::BINARY_OP;
+    BinaryOp op;
+    explicit BinaryOpNode(BinaryOp op) : ASTNode(KIND, intern(binaryOpText(op))), op(op) {}
+    ASTNode* left() const { return child(0); }
+    ASTNode* right() const { return child(1); }
+};
+
+// UnaryOp (op) [operand]
+struct UnaryOpNode : ASTNode {
+    static const ASTKind KIND = ASTKind::UNARY_OP;
+    UnaryOp op;
+    explicit UnaryOpNode(UnaryOp op) : ASTNode(KIND, intern(unaryOpText(op))), op(op) {}
+    ASTNode* operand() const { return child(0); }
+};
+
+// Index [Identifier or Index, subscript]; a[i][j] is Index(Index(a, i), j)
+struct IndexNode : ASTNode {
+    static const ASTKind KIND = ASTKind::INDEX;
+    IndexNode() : ASTNode(KIND) {}
+    ASTNode* base() const { return child(0); }
+    ASTNode* subscript() const { return child(1); }
+};
+
+// Identifier (name)
+struct IdentifierNode : ASTNode {
+    static const ASTKind KIND = ASTKind::IDENTIFIER;
+    explicit IdentifierNode(Symbol name) : ASTNode(KIND, name) {}
+    Symbol name() const { return value; }
+};
+
+// Integer (digits), the number is parsed once here
+struct IntegerNode : ASTNode {
+    static const ASTKind KIND = ASTKind::INTEGER;
+    int64_t number;
+    explicit IntegerNode(Symbol digits)
+        : ASTNode(KIND, digits), number(std::strtoll(std::string(symbolText(digits)).c_str(), nullptr, 10)) {}
+};
+
+// Real (digits)
+struct RealNode : ASTNode {
+    static const ASTKind KIND = ASTKind::REAL;
+    double number;
+    explicit RealNode(Symbol digits)
+        : ASTNode(KIND, digits), number(std::strtod(std::string(symbolText(digits)).c_str(), nullptr)) {}
+};
+
+// Checked downcast: the typed node, or nullptr if node is some other kind
+template <typename T>
+T* astCast(ASTNode* node) {
+    return node && node->kind == T::KIND ? static_cast<T*>(node) : nullptr;
+}
+
+template <typename T>
+const T* astCast(const ASTNode* node) {
+    return node && node->kind == T::KIND ? static_cast<const T*>(node) : nullptr;
+}
+
+// Visitor with one switch per node instead of virtual calls. Derive with
+// CRTP and override the visitX you need; the rest fall back to visitNode,
+// which visits the children in order.
+//
+//   struct Counter : ASTVisitor<Counter> {
+//       int assigns = 0;
+//       void visitAssign(AssignNode* node) { assigns++; visitNode(node); }
+//   };
+template <typename Derived, typename Result = void>
+class ASTVisitor {
+public:
+    Result visit(ASTNode* node) {
+        Derived& self = static_cast<Derived&>(*this);
+        switch (node->kind) {
+            case ASTKind::PROGRAM: return self.visitProgram(static_cast<ProgramNode*>(node));
+            case ASTKind::BLOCK: return self.visitBlock(static_cast<BlockNode*>(node));
+            case ASTKind::DECLARATION: return self.visitDeclaration(static_cast<DeclarationNode*>(node));
+            case ASTKind::TYPE: return self.visitType(static_cast<TypeNode*>(node));
+            case ASTKind::ASSIGN: return self.visitAssign(static_cast<AssignNode*>(node));
+            case ASTKind::IF: return self.visitIf(static_cast<IfNode*>(node));
+            case ASTKind::WHILE: return self.visitWhile(static_cast<WhileNode*>(node));
+            case ASTKind::DO_WHILE: return self.visitDoWhile(static_cast<DoWhileNode*>(node));
+            case ASTKind::RETURN: return self.visitReturn(static_cast<ReturnNode*>(node));
+            case ASTKind::BREAK: return self.visitBreak(static_cast<BreakNode*>(node));
+            case ASTKind::BINARY_OP: return self.visitBinaryOp(static_cast<BinaryOpNode*>(node));
+            case ASTKind::UNARY_OP: return self.visitUnaryOp(static_cast<UnaryOpNode*>(node));
+            case ASTKind::INDEX: return self.visitIndex(static_cast<IndexNode*>(node));
+            case ASTKind::IDENTIFIER: return self.visitIdentifier(static_cast<IdentifierNode*>(node));
+            case ASTKind::INTEGER: return self.visitInteger(static_cast<IntegerNode*>(node));
+            case ASTKind::REAL: return self.visitReal(static_cast<RealNode*>(node));
+        }
+        return Result();
+    }
+
+    Result visitNode(ASTNode* node) {
+        for (ASTNode* child : node->children) {
+            if (child) visit(child);
+        }
+        return Result();
+    }
+
+    Result visitProgram(ProgramNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitBlock(BlockNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitDeclaration(DeclarationNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitType(TypeNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitAssign(AssignNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitIf(IfNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitWhile(WhileNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitDoWhile(DoWhileNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitReturn(ReturnNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitBreak(BreakNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitBinaryOp(BinaryOpNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitUnaryOp(UnaryOpNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitIndex(IndexNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitIdentifier(IdentifierNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitInteger(IntegerNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+    Result visitReal(RealNode* node) { return static_cast<Derived&>(*this).visitNode(node); }
+};
+
+// The one place AST nodes are made. The parser calls it directly when it
+// builds the AST without a CST, and SemanticAnalyzer calls it when it
+// converts a CST, so both paths produce the same shapes (see the node
+// classes above).
+class ASTBuilder {
+public:
+    ASTNode* program(ASTNode* block) {
+        ProgramNode* node = new ProgramNode();
+        node->addChild(block);
+        return node;
+    }
+
+    ASTNode* block() { return new BlockNode(); }
+
+    // Declarations and statements, in source order
+    void append(ASTNode* block, ASTNode* item) { block->addChild(item); }
+
+    ASTNode* type(Symbol basic) { return new TypeNode(basic); }
+    void addDimension(ASTNode* type, Symbol size) { type->addChild(integer(size)); }
+
+    // Nodes a semantic error can point at take the position of their token
+    // (name, '=', operator, '[' or break); 0 leaves it unknown
+
+    ASTNode* declaration(Symbol name, ASTNode* type, uint32_t position = 0) {
+        DeclarationNode* node = new DeclarationNode(name);
+        node->position = position;
+        node->addChild(type);
+        return node;
+    }
+
+    ASTNode* assign(ASTNode* target, ASTNode* value, uint32_t position = 0) {
+        AssignNode* node = new AssignNode();
+        node->position = position;
+        node->addChild(target);
+        node->addChild(value);
+        return node;
+    }
+
+    // Bodies are added with addBody as they are parsed
+    ASTNode* ifStmt(ASTNode* condition) {
+        IfNode* node = new IfNode();
+        node->addChild(condition);
+        return node;
+    }
+
+    ASTNode* whileStmt(ASTNode* condition) {
+        WhileNode* node = new WhileNode();
+        node->addChild(condition);
+        return node;
+    }
+
+    ASTNode* doWhile() { return new DoWhileNode(); }
+
+    void addBody(ASTNode* stmt, ASTNode* body) { stmt->addChild(body); }
+
+    ASTNode* returnStmt(ASTNode* value) {
+        ReturnNode* node = new ReturnNode();
+        node->addChild(value);
+        return node;
+    }
+
+    ASTNode* breakStmt(uint32_t position = 0) {
+        BreakNode* node = new BreakNode();
+        node->position = position;
+        return node;
+    }
+
+    ASTNode* binary(TokenType op, ASTNode* left, ASTNode* right, uint32_t position = 0) {
+        BinaryOpNode* node = new BinaryOpNode(binaryOpFor(op));
+        node->position = position;
+        node->addChild(left);
+        node->addChild(right);
+        return node;
+    }
+
+    ASTNode* unary(TokenType op, ASTNode* operand, uint32_t position = 0) {
+        UnaryOpNode* node = new UnaryOpNode(unaryOpFor(op));
+        node->position = position;
+        node->addChild(operand);
+        return node;
+    }
+
+    ASTNode* index(ASTNode* base, ASTNode* subscript, uint32_t position = 0) {
+        IndexNode* node = new IndexNode();
+        node->position = position;
+        node->addChild(base);
+        node->addChild(subscript);
+        return node;
+    }
+
+    ASTNode* identifier(Symbol name, uint32_t position = 0) {
+        IdentifierNode* node = new IdentifierNode(name);
+        node->position = position;
+        return node;
+    }
+
+    ASTNode* integer(Symbol digits) { return new IntegerNode(digits); }
+    ASTNode* real(Symbol digits) { return new RealNode(digits); }
+};
+
+#endif
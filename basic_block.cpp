@@ -0,0 +1,351 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#define TAC_GENERATOR_NO_MAIN
+#include "tac_generator.cpp"
+using namespace std;
+
+typedef uint32_t BlockId;
+const BlockId NO_BLOCK = UINT32_MAX;
+
+// A maximal straight-line run of instructions: it's only entered at the
+// top and only left at the bottom.
+struct BasicBlock {
+    uint32_t begin;  // first instruction, its labels come first
+    uint32_t end;    // one past the last; a jump or return if it ends in one
+};
+
+// A run of blocks in one of the CFG's adjacency arrays
+class BlockList {
+    const BlockId* first;
+    const BlockId* last;
+
+public:
+    BlockList(const BlockId* first, const BlockId* last) : first(first), last(last) {}
+    const BlockId* begin() const { return first; }
+    const BlockId* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    BlockId operator[](size_t i) const { return first[i]; }
+};
+
+// Control-flow graph of a TAC program, with its dominator tree.
+//
+// Edges are kept like the FlatTree keeps children: the successors of b are
+// succ[succStart[b]] up to succ[succStart[b + 1]], predecessors likewise,
+// so a pass over all edges is a pass over two arrays. Everything is built in
+// time linear in the program, apart from the dominators: Lengauer and
+// Tarjan's semidominator algorithm with path compression, O(m log n) for
+// m edges. An iterative algorithm would settle in two passes here (every
+// loop is a while or do-while), but each pass climbs the tree once per
+// predecessor, and a run of labels closing nested ifs is a single join with
+// thousands of them. Passes that only need edges and block order can skip
+// the dominators altogether.
+class ControlFlowGraph {
+public:
+    vector<BasicBlock> blocks;      // block 0 is the entry
+    vector<BlockId> labelBlock;     // label index -> block it starts
+
+    vector<uint32_t> succStart;
+    vector<BlockId> succ;
+    vector<uint32_t> predStart;
+    vector<BlockId> pred;
+
+    vector<BlockId> order;          // reverse postorder of the blocks reachable from the entry
+    vector<uint32_t> orderIndex;    // block -> position in order, NO_BLOCK if unreachable
+
+    vector<BlockId> idom;           // immediate dominator, the entry's is itself, NO_BLOCK if unreachable
+    vector<uint32_t> domChildStart; // dominator tree children, same layout as succ
+    vector<BlockId> domChildren;
+    vector<uint32_t> domPre;        // dominator tree preorder number
+    vector<uint32_t> domLast;       // largest preorder number in the subtree
+
+    enum Detail { EDGES, DOMINATORS }; // EDGES leaves the five above empty
+
+    explicit ControlFlowGraph(const TACProgram& program, Detail detail = DOMINATORS) {
+        split(program);
+        link(program);
+        orderBlocks();
+        if (detail == DOMINATORS) computeDominators();
+    }
+
+    size_t size() const { return blocks.size(); }
+
+    BlockList successors(BlockId b) const {
+        return BlockList(succ.data() + succStart[b], succ.data() + succStart[b + 1]);
+    }
+    BlockList predecessors(BlockId b) const {
+        return BlockList(pred.data() + predStart[b], pred.data() + predStart[b + 1]);
+    }
+    BlockList dominatorChildren(BlockId b) const {
+        return BlockList(domChildren.data() + domChildStart[b], domChildren.data() + domChildStart[b + 1]);
+    }
+
+    bool reachable(BlockId b) const { return orderIndex[b] != NO_BLOCK; }
+
+    // Does a dominate b? O(1) with the tree numbering
+    bool dominates(BlockId a, BlockId b) const {
+        if (!reachable(a) || !reachable(b)) return false;
+        return domPre[a] <= domPre[b] && domPre[b] <= domLast[a];
+    }
+
+    void print(ostream& out, const TACProgram& program) const {
+        for (BlockId b = 0; b < blocks.size(); b++) {
+            out << "B" << b << ":";
+            printList(out, " preds", predecessors(b));
+            printList(out, " succs", successors(b));
+            if (!reachable(b)) {
+                out << " unreachable";
+            } else if (idom[b] != b) {
+                out << " idom B" << idom[b];
+            }
+            out << endl;
+            for (uint32_t i = blocks[b].begin; i < blocks[b].end; i++) {
+                program.print(out, program.code[i]);
+            }
+        }
+    }
+
+private:
+    static void printList(ostream& out, const char* name, BlockList list) {
+        if (list.empty()) return;
+        out << name;
+        for (BlockId b : list) {
+            out << " B" << b;
+        }
+    }
+
+    static bool endsBlock(const TACInstruction& in) {
+        return in.isJump() || in.op == TACOp::RETURN;
+    }
+
+    // Leaders: the first instruction, the first of each run of labels, and
+    // whatever follows a jump or return
+    void split(const TACProgram& program) {
+        const vector<TACInstruction>& code = program.code;
+        labelBlock.assign(program.labelCount, NO_BLOCK);
+        for (uint32_t i = 0; i < code.size(); i++) {
+            bool leader = i == 0 || endsBlock(code[i - 1]) ||
+                          (code[i].op == TACOp::LABEL && code[i - 1].op != TACOp::LABEL);
+            if (leader) {
+                if (!blocks.empty()) blocks.back().end = i;
+                blocks.push_back(BasicBlock{i, i});
+            }
+            if (code[i].op == TACOp::LABEL) {
+                labelBlock[code[i].result.index()] = (BlockId)blocks.size() - 1;
+            }
+        }
+        if (!blocks.empty()) blocks.back().end = (uint32_t)code.size();
+    }
+
+    // Successors from each block's last instruction, then predecessors by
+    // counting and filling
+    void link(const TACProgram& program) {
+        size_t count = blocks.size();
+        succStart.assign(count + 1, 0);
+        for (BlockId b = 0; b < count; b++) {
+            succStart[b] = (uint32_t)succ.size();
+            const TACInstruction& last = program.code[blocks[b].end - 1];
+            BlockId next = b + 1 < count ? b + 1 : NO_BLOCK;
+            if (last.op == TACOp::RETURN) continue;
+            if (last.isJump()) {
+                BlockId target = labelBlock[last.result.index()];
+                succ.push_back(target);
+                if (last.op == TACOp::JUMP || target == next) continue;
+            }
+            if (next != NO_BLOCK) succ.push_back(next);
+        }
+        succStart[count] = (uint32_t)succ.size();
+
+        predStart.assign(count + 1, 0);
+        for (BlockId s : succ) {
+            predStart[s + 1]++;
+        }
+        for (size_t b = 0; b < count; b++) {
+            predStart[b + 1] += predStart[b];
+        }
+        pred.resize(succ.size());
+        vector<uint32_t> fill(predStart.begin(), predStart.end() - 1);
+        for (BlockId b = 0; b < count; b++) {
+            for (BlockId s : successors(b)) {
+                pred[fill[s]++] = b;
+            }
+        }
+    }
+
+    // Depth-first from the entry on an explicit stack
+    void orderBlocks() {
+        size_t count = blocks.size();
+        orderIndex.assign(count, NO_BLOCK);
+        if (count == 0) return;
+
+        vector<bool> seen(count, false);
+        vector<pair<BlockId, uint32_t>> stack; // block, next successor to visit
+        stack.push_back(make_pair(0, 0));
+        seen[0] = true;
+        while (!stack.empty()) {
+            BlockId b = stack.back().first;
+            BlockList next = successors(b);
+            if (stack.back().second < next.size()) {
+                BlockId s = next[stack.back().second++];
+                if (!seen[s]) {
+                    seen[s] = true;
+                    stack.push_back(make_pair(s, 0));
+                }
+                continue;
+            }
+            order.push_back(b); // postorder
+            stack.pop_back();
+        }
+        reverse(order.begin(), order.end());
+        for (uint32_t i = 0; i < order.size(); i++) {
+            orderIndex[order[i]] = i;
+        }
+    }
+
+    // Lengauer-Tarjan over the depth-first spanning tree, vertices named by
+    // their preorder number. semi[w] is the semidominator, the smallest
+    // vertex with a path to w through vertices numbered above w. A forest
+    // of processed vertices (ancestor, label) answers "smallest semi on the
+    // tree path up to here" with path compression.
+    void computeDominators() {
+        size_t count = blocks.size();
+        idom.assign(count, NO_BLOCK);
+        if (count == 0) {
+            domChildStart.assign(1, 0);
+            return;
+        }
+
+        // Depth-first preorder and tree parents, on an explicit stack
+        vector<uint32_t> dfsNumber(count, NO_BLOCK);
+        vector<BlockId> vertex;
+        vector<uint32_t> parent;
+        vector<pair<BlockId, uint32_t>> dfs; // block, next successor to visit
+        dfs.push_back(make_pair(0, 0));
+        dfsNumber[0] = 0;
+        vertex.push_back(0);
+        parent.push_back(0);
+        while (!dfs.empty()) {
+            BlockId b = dfs.back().first;
+            BlockList next = successors(b);
+            if (dfs.back().second == next.size()) {
+                dfs.pop_back();
+                continue;
+            }
+            BlockId s = next[dfs.back().second++];
+            if (dfsNumber[s] != NO_BLOCK) continue;
+            dfsNumber[s] = (uint32_t)vertex.size();
+            vertex.push_back(s);
+            parent.push_back(dfsNumber[b]);
+            dfs.push_back(make_pair(s, 0));
+        }
+
+        size_t n = vertex.size();
+        vector<uint32_t> semi(n), label(n), ancestor(n, NO_BLOCK), dominator(n, 0);
+        vector<uint32_t> bucketHead(n, NO_BLOCK), bucketNext(n, NO_BLOCK);
+        for (uint32_t v = 0; v < n; v++) {
+            semi[v] = label[v] = v;
+        }
+        vector<uint32_t> path;
+        auto eval = [&](uint32_t v) {
+            if (ancestor[v] == NO_BLOCK) return v;
+            for (uint32_t x = v; ancestor[ancestor[x]] != NO_BLOCK; x = ancestor[x]) {
+                path.push_back(x);
+            }
+            // Compress from the top down, so each vertex sees its ancestor's
+            // label already settled
+            for (; !path.empty(); path.pop_back()) {
+                uint32_t x = path.back();
+                uint32_t a = ancestor[x];
+                if (semi[label[a]] < semi[label[x]]) label[x] = label[a];
+                ancestor[x] = ancestor[a];
+            }
+            return label[v];
+        };
+
+        for (uint32_t w = (uint32_t)n - 1; w > 0; w--) {
+            for (BlockId p : predecessors(vertex[w])) {
+                if (dfsNumber[p] == NO_BLOCK) continue; // unreachable
+                uint32_t u = eval(dfsNumber[p]);
+                if (semi[u] < semi[w]) semi[w] = semi[u];
+            }
+            bucketNext[w] = bucketHead[semi[w]];
+            bucketHead[semi[w]] = w;
+            ancestor[w] = parent[w];
+
+            // Everything whose semidominator is w's parent: its idom is the
+            // parent, or the same as that of a vertex between them
+            for (uint32_t v = bucketHead[parent[w]]; v != NO_BLOCK; v = bucketNext[v]) {
+                uint32_t u = eval(v);
+                dominator[v] = semi[u] < semi[v] ? u : parent[w];
+            }
+            bucketHead[parent[w]] = NO_BLOCK;
+        }
+        for (uint32_t w = 1; w < n; w++) {
+            if (dominator[w] != semi[w]) dominator[w] = dominator[dominator[w]];
+            idom[vertex[w]] = vertex[dominator[w]];
+        }
+        idom[0] = 0;
+
+        // Tree children, in reverse postorder
+        domChildStart.assign(count + 1, 0);
+        for (size_t i = 1; i < order.size(); i++) {
+            domChildStart[idom[order[i]] + 1]++;
+        }
+        for (size_t b = 0; b < count; b++) {
+            domChildStart[b + 1] += domChildStart[b];
+        }
+        domChildren.resize(order.empty() ? 0 : order.size() - 1);
+        vector<uint32_t> fill(domChildStart.begin(), domChildStart.end() - 1);
+        for (size_t i = 1; i < order.size(); i++) {
+            domChildren[fill[idom[order[i]]]++] = order[i];
+        }
+
+        // Preorder numbers, and the last one under each node
+        domPre.assign(count, NO_BLOCK);
+        domLast.assign(count, NO_BLOCK);
+        uint32_t number = 0;
+        vector<pair<BlockId, bool>> stack; // block, children done
+        stack.push_back(make_pair(0, false));
+        while (!stack.empty()) {
+            BlockId b = stack.back().first;
+            bool leaving = stack.back().second;
+            stack.pop_back();
+            if (leaving) {
+                domLast[b] = number - 1;
+                continue;
+            }
+            domPre[b] = number++;
+            stack.push_back(make_pair(b, true));
+            BlockList children = dominatorChildren(b);
+            for (size_t i = children.size(); i-- > 0;) {
+                stack.push_back(make_pair(children[i], false));
+            }
+        }
+    }
+};
+
+// optimizer.h includes this file for the CFG and optimizer.cpp has the main
+#ifndef BASIC_BLOCK_NO_MAIN
+
+// Usage: basic_block [file]. Without a file the built-in sample is used.
+// Prints each block with its edges and immediate dominator.
+int main(int argc, char* argv[]) {
+    SourceFile file;
+    if (argc > 1 && !file.open(argv[1])) return 1;
+    string_view source = argc > 1 ? file.text() : string_view(SAMPLE_PROGRAM);
+
+    Diagnostics diagnostics;
+    TACProgram program;
+    if (!compileToTAC(source, program, diagnostics)) {
+        diagnostics.print(cerr);
+        return 1;
+    }
+
+    ControlFlowGraph cfg(program);
+    cout << "Basic blocks:" << endl;
+    cfg.print(cout, program);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,385 @@
+#include "optimizer.h"
+#include <algorithm>
+#include <queue>
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Sparse conditional constant propagation (Wegman and Zadeck). Every value
+// sits on a three-level lattice: TOP (nothing seen yet), one constant, or
+// BOTTOM (could be anything). Blocks are only looked at once an executable
+// edge reaches them, and a branch whose condition is a constant only makes
+// the edge it takes executable, so code behind a dead branch never lowers
+// anything it would have met.
+//
+// A temp has one value for the whole program, the meet of its writes: most
+// are written once, the 0/1 temp of a condition in a value on two paths
+// that never both run, and a phi's temp out of SSA once per edge. A change
+// revisits just the blocks that read it.
+// Variables get a value per block instead: the facts on entry to each block,
+// kept only for the variables that aren't BOTTOM there. Variables start out
+// BOTTOM, since nothing is known about memory on entry. Array elements are
+// never tracked; a load is always BOTTOM.
+// ---------------------------------------------------------------------------
+
+class ConstantPropagation {
+    typedef uint32_t Lattice; // a canonical constant, or one of these
+    static constexpr Lattice TOP = UINT32_MAX - 1;
+    static constexpr Lattice BOTTOM = UINT32_MAX;
+
+    struct Fact {
+        uint32_t variable;
+        Lattice value;
+    };
+
+    TACProgram& program;
+    ConstantPool constants;
+    ControlFlowGraph cfg;
+
+    vector<bool> executable;
+    vector<vector<Fact>> facts;    // per block, on entry, sorted by variable
+    vector<Lattice> tempValue;
+    vector<uint32_t> tempUseStart; // blocks reading each temp, same layout as cfg.succ
+    vector<BlockId> tempUses;
+
+    // Variable values while walking a block; BOTTOM between walks
+    vector<Lattice> state;
+    vector<uint32_t> touched;
+
+    priority_queue<pair<uint32_t, BlockId>, vector<pair<uint32_t, BlockId>>, greater<pair<uint32_t, BlockId>>> work;
+    vector<bool> queued;
+
+    ConstantPropagationStats stats;
+
+    static Lattice meet(Lattice a, Lattice b) {
+        if (a == TOP) return b;
+        if (b == TOP || a == b) return a;
+        return BOTTOM;
+    }
+
+    static bool isConstant(Lattice value) { return value < TOP; }
+
+    Lattice value(TACOperand operand) const {
+        switch (operand.kind()) {
+            case TACOperand::TEMP: return tempValue[operand.index()];
+            case TACOperand::VARIABLE: return state[operand.index()];
+            case TACOperand::CONSTANT: return constants.canonical(operand.index());
+            default: return BOTTOM;
+        }
+    }
+
+    // Only int and float values live here; char arithmetic is int
+    static bool truth(const TACConstant& value) {
+        return value.type == ValueType::FLOAT ? value.real != 0.0 : value.integer != 0;
+    }
+
+    // The constant op gives, or BOTTOM where it's left to run time
+    // (division by zero, a float that doesn't fit an int)
+    Lattice fold(TACOp op, ValueType type, Lattice left, Lattice right) {
+        const TACConstant& a = constants[left];
+        const TACConstant& b = constants[isConstant(right) ? right : left];
+        if (type == ValueType::FLOAT) {
+            double x = a.real, y = b.real;
+            switch (op) {
+                case TACOp::ADD: return constants.real(x + y);
+                case TACOp::SUB: return constants.real(x - y);
+                case TACOp::MUL: return constants.real(x * y);
+                case TACOp::DIV: return constants.real(x / y);
+                case TACOp::EQ: return constants.integer(x == y);
+                case TACOp::NE: return constants.integer(x != y);
+                case TACOp::LT: return constants.integer(x < y);
+                case TACOp::LE: return constants.integer(x <= y);
+                case TACOp::GT: return constants.integer(x > y);
+                case TACOp::GE: return constants.integer(x >= y);
+                case TACOp::NEG: return constants.real(-x);
+                case TACOp::NOT: return constants.integer(x == 0.0);
+                case TACOp::TO_INT:
+                case TACOp::TO_CHAR:
+                    if (!(x >= -9223372036854775808.0 && x < 9223372036854775808.0)) return BOTTOM;
+                    return constants.integer(op == TACOp::TO_CHAR ? (int8_t)(int64_t)x : (int64_t)x);
+                default: return BOTTOM;
+            }
+        }
+
+        // Wraps around like the machine would, instead of overflowing
+        int64_t x = a.integer, y = b.integer;
+        uint64_t ux = (uint64_t)x, uy = (uint64_t)y;
+        switch (op) {
+            case TACOp::ADD: return constants.integer((int64_t)(ux + uy));
+            case TACOp::SUB: return constants.integer((int64_t)(ux - uy));
+            case TACOp::MUL: return constants.integer((int64_t)(ux * uy));
+            case TACOp::DIV:
+                if (y == 0 || (x == INT64_MIN && y == -1)) return BOTTOM;
+                return constants.integer(x / y);
+            case TACOp::EQ: return constants.integer(x == y);
+            case TACOp::NE: return constants.integer(x != y);
+            case TACOp::LT: return constants.integer(x < y);
+            case TACOp::LE: return constants.integer(x <= y);
+            case TACOp::GT: return constants.integer(x > y);
+            case TACOp::GE: return constants.integer(x >= y);
+            case TACOp::NEG: return constants.integer((int64_t)(0 - ux));
+            case TACOp::NOT: return constants.integer(x == 0);
+            case TACOp::TO_FLOAT: return constants.real((double)x);
+            case TACOp::TO_CHAR: return constants.integer((int8_t)x);
+            case TACOp::TO_INT: return constants.integer(x);
+            default: return BOTTOM;
+        }
+    }
+
+    static bool isUnary(TACOp op) {
+        return op == TACOp::NEG || op == TACOp::NOT || op == TACOp::TO_FLOAT || op == TACOp::TO_INT ||
+               op == TACOp::TO_CHAR || op == TACOp::COPY;
+    }
+
+    // Value of an instruction that computes one
+    Lattice evaluate(const TACInstruction& in) {
+        if (in.op == TACOp::LOAD) return BOTTOM;
+        Lattice a = value(in.a);
+        if (in.op == TACOp::COPY) return a;
+        Lattice b = isUnary(in.op) ? a : value(in.b);
+        if (a == BOTTOM || b == BOTTOM) return BOTTOM;
+        if (a == TOP || b == TOP) return TOP;
+        return fold(in.op, in.type, a, b);
+    }
+
+    // Whether an IF or IF_FALSE jumps: a constant 1 or 0, TOP or BOTTOM
+    Lattice branch(const TACInstruction& in) {
+        Lattice a = value(in.a);
+        Lattice test;
+        if (in.condition == TACCondition::TRUTH) {
+            test = isConstant(a) ? constants.integer(truth(constants[a])) : a;
+        } else {
+            TACOp compare = static_cast<TACOp>(static_cast<int>(TACOp::EQ) + static_cast<int>(in.condition) - 1);
+            test = evaluate(TACInstruction(compare, in.type, TACOperand(), in.a, in.b));
+        }
+        if (!isConstant(test) || in.op == TACOp::IF) return test;
+        return constants.integer(!truth(constants[test]));
+    }
+
+    void push(BlockId b) {
+        if (queued[b]) return;
+        queued[b] = true;
+        work.push(make_pair(cfg.orderIndex[b], b));
+    }
+
+    void setVariable(uint32_t variable, Lattice value) {
+        if (state[variable] == BOTTOM) touched.push_back(variable);
+        state[variable] = value;
+    }
+
+    void setTemp(uint32_t temp, Lattice value) {
+        Lattice lowered = meet(tempValue[temp], value);
+        if (lowered == tempValue[temp]) return;
+        tempValue[temp] = lowered;
+        for (uint32_t i = tempUseStart[temp]; i < tempUseStart[temp + 1]; i++) {
+            if (executable[tempUses[i]]) push(tempUses[i]);
+        }
+    }
+
+    void assign(TACOperand result, Lattice value) {
+        if (result.is(TACOperand::TEMP)) setTemp(result.index(), value);
+        else setVariable(result.index(), value);
+    }
+
+    void loadFacts(BlockId b) {
+        for (const Fact& fact : facts[b]) {
+            setVariable(fact.variable, fact.value);
+        }
+    }
+
+    void clearState() {
+        for (uint32_t variable : touched) {
+            state[variable] = BOTTOM;
+        }
+        touched.clear();
+    }
+
+    // The state at the end of a block flows along an edge it takes
+    void flow(BlockId to) {
+        vector<Fact>& entry = facts[to];
+        if (!executable[to]) {
+            executable[to] = true;
+            sort(touched.begin(), touched.end());
+            touched.erase(unique(touched.begin(), touched.end()), touched.end());
+            for (uint32_t variable : touched) {
+                if (state[variable] != BOTTOM) entry.push_back(Fact{variable, state[variable]});
+            }
+            push(to);
+            return;
+        }
+        size_t kept = 0;
+        bool changed = false;
+        for (const Fact& fact : entry) {
+            Lattice lowered = meet(fact.value, state[fact.variable]);
+            changed |= lowered != fact.value;
+            if (lowered != BOTTOM) entry[kept++] = Fact{fact.variable, lowered};
+        }
+        entry.resize(kept);
+        if (changed) push(to);
+    }
+
+    // Where a block's last instruction goes; the branch value is TOP or
+    // BOTTOM for no decision
+    void followEdges(BlockId b, const TACInstruction& last, Lattice decision) {
+        BlockId next = b + 1 < cfg.size() ? b + 1 : NO_BLOCK;
+        if (last.op == TACOp::RETURN) return;
+        if (last.op == TACOp::JUMP) {
+            flow(cfg.labelBlock[last.result.index()]);
+            return;
+        }
+        if (last.op == TACOp::IF || last.op == TACOp::IF_FALSE) {
+            if (decision == TOP) return;
+            BlockId target = cfg.labelBlock[last.result.index()];
+            bool jumps = isConstant(decision) && truth(constants[decision]);
+            if (decision == BOTTOM || jumps) flow(target);
+            if (jumps || target == next) return;
+        }
+        if (next != NO_BLOCK) flow(next);
+    }
+
+    void visit(BlockId b) {
+        loadFacts(b);
+        const BasicBlock& block = cfg.blocks[b];
+        Lattice decision = BOTTOM;
+        for (uint32_t i = block.begin; i < block.end; i++) {
+            const TACInstruction& in = program.code[i];
+            switch (in.op) {
+                case TACOp::LABEL:
+                case TACOp::STORE:
+                case TACOp::JUMP:
+                case TACOp::RETURN:
+                    break;
+                case TACOp::IF:
+                case TACOp::IF_FALSE:
+                    decision = branch(in);
+                    break;
+                default:
+                    assign(in.result, evaluate(in));
+                    break;
+            }
+        }
+        followEdges(b, program.code[block.end - 1], decision);
+        clearState();
+    }
+
+    void indexTempUses() {
+        tempUseStart.assign(program.temps.size() + 1, 0);
+        auto each = [&](auto&& use) {
+            for (BlockId b = 0; b < cfg.size(); b++) {
+                for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                    const TACInstruction& in = program.code[i];
+                    if (in.a.is(TACOperand::TEMP)) use(in.a.index(), b);
+                    if (in.b.is(TACOperand::TEMP)) use(in.b.index(), b);
+                }
+            }
+        };
+        each([&](uint32_t temp, BlockId) { tempUseStart[temp + 1]++; });
+        for (size_t t = 0; t < program.temps.size(); t++) {
+            tempUseStart[t + 1] += tempUseStart[t];
+        }
+        tempUses.resize(tempUseStart.back());
+        vector<uint32_t> fill(tempUseStart.begin(), tempUseStart.end() - 1);
+        each([&](uint32_t temp, BlockId b) { tempUses[fill[temp]++] = b; });
+    }
+
+    // Replace an operand known to be constant
+    void substitute(TACOperand& operand) {
+        if (!operand.is(TACOperand::TEMP) && !operand.is(TACOperand::VARIABLE)) return;
+        Lattice known = value(operand);
+        if (!isConstant(known)) return;
+        operand = TACOperand::constant(known);
+        stats.operands++;
+    }
+
+    // Second walk over the executable blocks with the final values:
+    // constant temps disappear into their uses, constant assignments
+    // become copies of the constant and decided branches go
+    void rewrite() {
+        vector<TACInstruction> code;
+        code.reserve(program.code.size());
+        for (BlockId b = 0; b < cfg.size(); b++) {
+            if (!executable[b]) {
+                stats.deadBlocks++;
+                continue;
+            }
+            loadFacts(b);
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                TACInstruction in = program.code[i];
+                switch (in.op) {
+                    case TACOp::LABEL:
+                    case TACOp::JUMP:
+                        break;
+                    case TACOp::RETURN:
+                    case TACOp::STORE:
+                        substitute(in.a);
+                        if (in.op == TACOp::STORE) substitute(in.b);
+                        break;
+                    case TACOp::IF:
+                    case TACOp::IF_FALSE: {
+                        Lattice decision = branch(in);
+                        if (isConstant(decision)) {
+                            stats.branches++;
+                            if (!truth(constants[decision])) continue;
+                            in = TACInstruction(TACOp::JUMP, ValueType::UNKNOWN, in.result);
+                            break;
+                        }
+                        substitute(in.a);
+                        substitute(in.b);
+                        break;
+                    }
+                    default: {
+                        Lattice result = evaluate(in);
+                        bool constantCopy = in.op == TACOp::COPY && in.a.is(TACOperand::CONSTANT);
+                        if (isConstant(result) && !constantCopy) {
+                            stats.folded++;
+                            // A temp written more than once (out of SSA) may
+                            // be constant here and not elsewhere
+                            if (in.result.is(TACOperand::TEMP) && isConstant(value(in.result))) continue;
+                            ValueType type = in.result.is(TACOperand::TEMP) ? program.temps[in.result.index()]
+                                                                            : program.variables[in.result.index()].type;
+                            in = TACInstruction(TACOp::COPY, type, in.result, TACOperand::constant(result));
+                        } else if (in.op != TACOp::LOAD) {
+                            substitute(in.a);
+                            substitute(in.b);
+                        } else {
+                            substitute(in.b);
+                        }
+                        if (in.result.is(TACOperand::VARIABLE)) setVariable(in.result.index(), result);
+                        break;
+                    }
+                }
+                code.push_back(in);
+            }
+            clearState();
+        }
+        program.code.swap(code);
+    }
+
+public:
+    explicit ConstantPropagation(TACProgram& program)
+        : program(program), constants(program), cfg(program, ControlFlowGraph::EDGES) {}
+
+    ConstantPropagationStats run() {
+        if (cfg.size() == 0) return stats;
+        executable.assign(cfg.size(), false);
+        queued.assign(cfg.size(), false);
+        facts.resize(cfg.size());
+        tempValue.assign(program.temps.size(), TOP);
+        state.assign(program.variables.size(), BOTTOM);
+        indexTempUses();
+
+        executable[0] = true;
+        push(0);
+        while (!work.empty()) {
+            BlockId b = work.top().second;
+            work.pop();
+            queued[b] = false;
+            visit(b);
+        }
+        rewrite();
+        return stats;
+    }
+};
+
+ConstantPropagationStats propagateConstants(TACProgram& program) {
+    return ConstantPropagation(program).run();
+}
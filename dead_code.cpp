@@ -0,0 +1,197 @@
+#include "optimizer.h"
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Dead code elimination. Blocks the entry never reaches go first (code after
+// a return or break, branches constant propagation decided), then one walk
+// backwards over the code marks what has to stay: returns, jumps that go
+// somewhere, writes of a name live after them and stores to an array a
+// later load can see. Nothing here has side effects apart from stores,
+// jumps and return, and only the reads of instructions that stay make a
+// name live, so a chain of writes feeding only each other is never live,
+// however many blocks it crosses.
+//
+// A jump or branch to one of the labels right after it does nothing, with
+// what's been found dead in between seen through, so "if (c < 0) c = 0;"
+// with c never read again goes in the same walk as the write. The live
+// names at each label are kept as rows of 64-bit words; a jump back to a
+// label earlier in the code uses the row from the walk before, so the walk
+// repeats until no row grows, about once per level of loop nesting.
+// Labels nothing jumps to any more go at the end.
+// ---------------------------------------------------------------------------
+
+class DeadCodeElimination {
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    TACProgram& program;
+    vector<bool> removed;
+    DeadCodeStats stats;
+
+    // Names read in a stretch of straight-line code before it writes them
+    // get a bit; the rest are only live between their write and reads in
+    // the one stretch and are kept in local
+    vector<uint32_t> slotOfName;
+    size_t words;
+    vector<uint64_t> atLabel;     // label -> names live there
+    vector<uint64_t> current;     // slotted names live at the current point of the walk
+    vector<bool> local;
+    vector<uint32_t> labelRun;    // label -> instructions kept after it, when the walk passed it
+
+    uint32_t nameOf(TACOperand operand) const { return nameIndex(program, operand); }
+
+    bool isLive(uint32_t name) const {
+        uint32_t s = slotOfName[name];
+        return s == NO_SLOT ? local[name] : (current[s / 64] >> (s % 64) & 1);
+    }
+
+    void setLive(uint32_t name, bool value) {
+        uint32_t s = slotOfName[name];
+        if (s == NO_SLOT) {
+            local[name] = value;
+        } else if (value) {
+            current[s / 64] |= 1ull << (s % 64);
+        } else {
+            current[s / 64] &= ~(1ull << (s % 64));
+        }
+    }
+
+    void compact() {
+        size_t kept = 0;
+        for (size_t i = 0; i < program.code.size(); i++) {
+            if (!removed[i]) program.code[kept++] = program.code[i];
+        }
+        program.code.erase(program.code.begin() + kept, program.code.end());
+    }
+
+    void removeUnreachable() {
+        ControlFlowGraph cfg(program, ControlFlowGraph::EDGES);
+        removed.assign(program.code.size(), false);
+        for (BlockId b = 0; b < cfg.size(); b++) {
+            if (cfg.reachable(b)) continue;
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                removed[i] = true;
+            }
+            stats.unreachable += cfg.blocks[b].end - cfg.blocks[b].begin;
+        }
+        compact();
+    }
+
+    void findGlobalNames() {
+        size_t count = program.variables.size() + program.temps.size();
+        vector<bool> global(count, false);
+        vector<uint32_t> writtenIn(count, UINT32_MAX);
+        uint32_t stretch = 0;
+        for (const TACInstruction& in : program.code) {
+            if (in.op == TACOp::LABEL) stretch++;
+            forEachRead(in, [&](TACOperand name) {
+                if (writtenIn[nameOf(name)] != stretch) global[nameOf(name)] = true;
+            });
+            TACOperand written = writtenBy(in);
+            if (!written.none()) writtenIn[nameOf(written)] = stretch;
+            if (in.isJump() || in.op == TACOp::RETURN) stretch++;
+        }
+
+        slotOfName.assign(count, NO_SLOT);
+        uint32_t slots = 0;
+        for (uint32_t n = 0; n < count; n++) {
+            if (global[n]) slotOfName[n] = slots++;
+        }
+        words = (slots + 63) / 64;
+    }
+
+    // One backward walk; true if the names live at some label grew. With
+    // sweep, what isn't kept is marked removed.
+    bool walk(bool sweep) {
+        const vector<TACInstruction>& code = program.code;
+        bool grew = false;
+        current.assign(words, 0);
+        labelRun.assign(program.labelCount, UINT32_MAX);
+        uint32_t run = 0;
+        for (size_t i = code.size(); i-- > 0;) {
+            const TACInstruction& in = code[i];
+            if (in.op == TACOp::LABEL) {
+                uint32_t label = in.result.index();
+                labelRun[label] = run;
+                uint64_t* row = &atLabel[label * words];
+                for (size_t w = 0; w < words; w++) {
+                    grew |= (current[w] & ~row[w]) != 0;
+                    row[w] |= current[w];
+                }
+                continue;
+            }
+
+            bool kept;
+            if (in.isJump()) {
+                uint32_t label = in.result.index();
+                kept = labelRun[label] != run;
+                if (kept) {
+                    const uint64_t* row = &atLabel[label * words];
+                    for (size_t w = 0; w < words; w++) {
+                        current[w] = in.op == TACOp::JUMP ? row[w] : current[w] | row[w];
+                    }
+                }
+            } else if (in.op == TACOp::RETURN) {
+                kept = true;
+                current.assign(words, 0);
+            } else if (in.op == TACOp::STORE) {
+                kept = isLive(nameOf(in.result));
+            } else {
+                uint32_t written = nameOf(writtenBy(in));
+                kept = isLive(written);
+                if (kept) setLive(written, false);
+            }
+
+            if (kept) {
+                run++;
+                forEachRead(in, [&](TACOperand name) { setLive(nameOf(name), true); });
+            } else if (sweep) {
+                removed[i] = true;
+                if (in.isJump()) {
+                    stats.jumps++;
+                } else if (in.op == TACOp::STORE) {
+                    stats.deadStores++;
+                } else {
+                    stats.dead++;
+                }
+            }
+        }
+        return grew;
+    }
+
+    void removeLabels() {
+        vector<TACInstruction>& code = program.code;
+        vector<bool> targeted(program.labelCount, false);
+        for (const TACInstruction& in : code) {
+            if (in.isJump()) targeted[in.result.index()] = true;
+        }
+        removed.assign(code.size(), false);
+        for (size_t i = 0; i < code.size(); i++) {
+            if (code[i].op == TACOp::LABEL && !targeted[code[i].result.index()]) {
+                removed[i] = true;
+                stats.jumps++;
+            }
+        }
+        compact();
+    }
+
+public:
+    explicit DeadCodeElimination(TACProgram& program) : program(program), words(0) {}
+
+    DeadCodeStats run() {
+        removeUnreachable();
+        findGlobalNames();
+        atLabel.assign(program.labelCount * words, 0);
+        local.assign(slotOfName.size(), false);
+        while (walk(false)) {
+        }
+        removed.assign(program.code.size(), false);
+        walk(true);
+        compact();
+        removeLabels();
+        return stats;
+    }
+};
+
+DeadCodeStats eliminateDeadCode(TACProgram& program) {
+    return DeadCodeElimination(program).run();
+}
@@ -0,0 +1,63 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Which phase found the problem, printed in front of the message
+enum class DiagnosticKind : uint8_t { SYNTAX, SEMANTIC };
+
+struct Diagnostic {
+    DiagnosticKind kind;
+    std::string message;
+    std::string tokenText;  // offending lexeme, empty if there is none (end of input)
+    uint32_t line;          // 0 when the position is unknown
+    uint32_t column;
+};
+
+// Every error of a compile, in the order they were found. Phases report
+// here and keep going instead of exiting, so one run over a file shows all
+// of its errors and the compiler is safe to call from a long-lived process.
+class Diagnostics {
+private:
+    std::vector<Diagnostic> entries;
+
+public:
+    void report(DiagnosticKind kind, std::string message, std::string_view tokenText = std::string_view(),
+                uint32_t line = 0, uint32_t column = 0) {
+        entries.push_back({kind, std::move(message), std::string(tokenText), line, column});
+    }
+
+    bool hasErrors() const { return !entries.empty(); }
+    size_t count() const { return entries.size(); }
+    const std::vector<Diagnostic>& all() const { return entries; }
+    void clear() { entries.clear(); }
+
+    // For an edit that moved text without changing what it means: move
+    // each known position to wherever its token went
+    template <typename Move>
+    void movePositions(Move move) {
+        for (Diagnostic& d : entries) {
+            if (d.line != 0) move(d.line, d.column);
+        }
+    }
+
+    // One line each: "Syntax Error: Expected ; at token 'b' (line 3, column 5)"
+    void print(std::ostream& out) const {
+        for (const Diagnostic& d : entries) {
+            out << (d.kind == DiagnosticKind::SYNTAX ? "Syntax Error: " : "Semantic Error: ") << d.message;
+            if (!d.tokenText.empty()) {
+                out << " at token '" << d.tokenText << "'";
+            }
+            if (d.line != 0) {
+                out << " (line " << d.line << ", column " << d.column << ")";
+            }
+            out << std::endl;
+        }
+    }
+};
+
+#endif
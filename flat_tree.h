@@ -0,0 +1,97 @@
+#ifndef FLAT_TREE_H
+#define FLAT_TREE_H
+
+#include <cstdint>
+#include <vector>
+#include "interner.h"
+#include "token.h"
+
+typedef uint32_t FlatIndex;
+const FlatIndex NO_NODE = UINT32_MAX;
+
+// A tree stored as parallel arrays, one entry per node, in preorder. Node 0
+// is the root, a node's first child (if any) is the very next entry, and
+// its whole subtree is the range [i, subtreeEnd[i]). So a full walk is a
+// linear scan over the arrays and skipping a subtree is one index jump,
+// no pointer chasing. Kind is NodeType for CSTs and whatever the AST uses.
+template <typename Kind>
+struct FlatTree {
+    std::vector<Kind> kind;
+    std::vector<Symbol> value;          // lexeme, EMPTY_SYMBOL if none
+    std::vector<TokenType> token;       // token type for CST terminals, INVALID otherwise
+    std::vector<FlatIndex> firstChild;  // NO_NODE for leaves
+    std::vector<FlatIndex> nextSibling; // NO_NODE for last children
+    std::vector<FlatIndex> subtreeEnd;  // one past the last node of the subtree
+    std::vector<uint32_t> depth;        // root is 0
+
+    size_t size() const { return kind.size(); }
+    bool isLeaf(FlatIndex i) const { return firstChild[i] == NO_NODE; }
+
+    void reserve(size_t n) {
+        kind.reserve(n);
+        value.reserve(n);
+        token.reserve(n);
+        firstChild.reserve(n);
+        nextSibling.reserve(n);
+        subtreeEnd.reserve(n);
+        depth.reserve(n);
+    }
+};
+
+// Flatten a pointer tree. Traits supplies, for the node type:
+//   Kind kind(const Node*), Symbol value(const Node*),
+//   TokenType token(const Node*), and children(const Node*) (any range).
+// Uses an explicit stack, so tree depth is only limited by memory.
+template <typename Kind, typename Node, typename Traits>
+FlatTree<Kind> flattenTree(const Node* root, Traits traits) {
+    FlatTree<Kind> tree;
+    if (!root) return tree;
+
+    struct Pending {
+        const Node* node;
+        FlatIndex parent;
+        uint32_t depth;
+    };
+    std::vector<Pending> stack;
+    std::vector<FlatIndex> lastChild;
+    std::vector<const Node*> kids;
+    stack.push_back({root, NO_NODE, 0});
+
+    while (!stack.empty()) {
+        Pending item = stack.back();
+        stack.pop_back();
+
+        FlatIndex i = (FlatIndex)tree.size();
+        tree.kind.push_back(traits.kind(item.node));
+        tree.value.push_back(traits.value(item.node));
+        tree.token.push_back(traits.token(item.node));
+        tree.firstChild.push_back(NO_NODE);
+        tree.nextSibling.push_back(NO_NODE);
+        tree.subtreeEnd.push_back(i + 1);
+        tree.depth.push_back(item.depth);
+        lastChild.push_back(NO_NODE);
+
+        if (item.parent != NO_NODE) {
+            if (lastChild[item.parent] == NO_NODE) tree.firstChild[item.parent] = i;
+            else tree.nextSibling[lastChild[item.parent]] = i;
+            lastChild[item.parent] = i;
+        }
+
+        // Push children in reverse so the first one is visited next
+        kids.clear();
+        for (const Node* child : traits.children(item.node)) {
+            if (child) kids.push_back(child);
+        }
+        for (size_t k = kids.size(); k-- > 0;) {
+            stack.push_back({kids[k], i, item.depth + 1});
+        }
+    }
+
+    // A subtree ends where its last child's subtree ends
+    for (size_t i = tree.size(); i-- > 0;) {
+        if (lastChild[i] != NO_NODE) tree.subtreeEnd[i] = tree.subtreeEnd[lastChild[i]];
+    }
+    return tree;
+}
+
+#endif
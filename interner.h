@@ -0,0 +1,146 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Interned string ID. The same text always gets the same ID, so comparing
+// two names is an integer compare. ID 0 is always the empty string.
+typedef uint32_t Symbol;
+const Symbol EMPTY_SYMBOL = 0;
+
+// FxHash-style string hash: one rotate/xor/multiply per 8 bytes
+inline uint64_t hashString(std::string_view text) {
+    const uint64_t seed = 0x517cc1b727220a95ULL;
+    uint64_t h = 0;
+    size_t i = 0;
+    for (; i + 8 <= text.length(); i += 8) {
+        uint64_t word;
+        memcpy(&word, text.data() + i, 8);
+        h = (((h << 5) | (h >> 59)) ^ word) * seed;
+    }
+    if (i < text.length()) {
+        uint64_t word = 0;
+        memcpy(&word, text.data() + i, text.length() - i);
+        h = (((h << 5) | (h >> 59)) ^ word) * seed;
+    }
+    return ((h << 5) | (h >> 59)) ^ text.length();
+}
+
+// String pool shared by every phase. Text is copied once into fixed-size
+// chunks that never move, so the string_view for an ID stays valid for the
+// life of the program. Not thread safe: intern from one thread only.
+class StringInterner {
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    size_t chunkUsed;
+    std::vector<std::string_view> strings; // ID -> text
+    std::vector<uint32_t> hashes;          // ID -> low hash bits
+    std::vector<uint32_t> slots;           // open addressing, ID + 1 (0 = empty)
+
+    std::string_view store(std::string_view text) {
+        if (text.empty()) return std::string_view();
+        if (text.length() > CHUNK_SIZE / 4) {
+            // Big strings get their own block so they don't waste a chunk
+            chunks.emplace_back(new char[text.length()]);
+            memcpy(chunks.back().get(), text.data(), text.length());
+            std::string_view stored(chunks.back().get(), text.length());
+            // Keep bump-allocating from the previous chunk
+            std::swap(chunks.back(), chunks[chunks.size() - 2]);
+            return stored;
+        }
+        if (chunkUsed + text.length() > CHUNK_SIZE) {
+            chunks.emplace_back(new char[CHUNK_SIZE]);
+            chunkUsed = 0;
+        }
+        char* dest = chunks.back().get() + chunkUsed;
+        memcpy(dest, text.data(), text.length());
+        chunkUsed += text.length();
+        return std::string_view(dest, text.length());
+    }
+
+    void grow() {
+        std::vector<uint32_t> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, 0);
+        size_t mask = slots.size() - 1;
+        for (uint32_t entry : old) {
+            if (entry == 0) continue;
+            size_t i = hashes[entry - 1] & mask;
+            while (slots[i] != 0) i = (i + 1) & mask;
+            slots[i] = entry;
+        }
+    }
+
+    // Slot holding text, or the empty slot where it would go
+    size_t probe(std::string_view text, uint32_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i] != 0) {
+            uint32_t id = slots[i] - 1;
+            if (hashes[id] == hash && strings[id] == text) break;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+public:
+    StringInterner() : chunkUsed(0) {
+        chunks.emplace_back(new char[CHUNK_SIZE]);
+        slots.assign(1024, 0);
+        intern(std::string_view()); // EMPTY_SYMBOL
+    }
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    Symbol intern(std::string_view text) {
+        uint32_t hash = (uint32_t)(hashString(text) >> 32);
+        size_t i = probe(text, hash);
+        if (slots[i] != 0) return slots[i] - 1;
+
+        Symbol id = (Symbol)strings.size();
+        strings.push_back(store(text));
+        hashes.push_back(hash);
+        slots[i] = id + 1;
+        if (strings.size() * 2 > slots.size()) grow();
+        return id;
+    }
+
+    // ID of text if it was ever interned, EMPTY_SYMBOL if not. Never adds
+    // to the pool, so lookups of names nobody declared leave no trace.
+    Symbol find(std::string_view text) const {
+        size_t i = probe(text, (uint32_t)(hashString(text) >> 32));
+        return slots[i] != 0 ? slots[i] - 1 : EMPTY_SYMBOL;
+    }
+
+    std::string_view text(Symbol id) const {
+        return strings[id];
+    }
+
+    size_t size() const {
+        return strings.size();
+    }
+};
+
+// The one pool every phase shares
+inline StringInterner& stringPool() {
+    static StringInterner pool;
+    return pool;
+}
+
+inline Symbol intern(std::string_view text) {
+    return stringPool().intern(text);
+}
+
+inline std::string_view symbolText(Symbol id) {
+    return stringPool().text(id);
+}
+
+#endif
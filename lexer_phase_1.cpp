@@ -2,317 +2,587 @@
 #include <string>
 #include <cctype>
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "symbol_table.cpp"
+#include "token.h"
+#include "source_file.cpp"
+#include "lexer_simd.cpp"
 using namespace std;
 
-// Define token types
-enum TokenType {
-    KEYWORD, IDENTIFIER, COMMENT, INVALID,
-    LEFT_PAREN, RIGHT_PAREN, LEFT_BRACKET, RIGHT_BRACKET,
-    LEFT_BRACE, RIGHT_BRACE, DOT, SEMICOLON, COMMA,
-    PLUS, MINUS, MULTIPLY, DIVIDE, MODULUS, ASSIGNMENT,
-    INCREMENT, DECREMENT, LESS_THAN, LESS_THAN_EQ,
-    GREATER_THAN, GREATER_THAN_EQ, LOGIC_EQUAL,
-    LOGIC_AND, LOGIC_OR, LOGIC_NOT, BIT_AND, BIT_OR, LOGIC_NOT_EQUAL,
-    BASIC, INTEGER, REAL, // update basic  phase 2
-    IF, ELSE, WHILE, BREAK, MAIN, DO, // update token phase 2
-    RETURN // add RETURN token
+// Keywords and basic types according to the specification (update basic phase 2).
+// They live in a perfect hash keyed on length and first/last character, so an
+// identifier is classified with one probe and at most one memcmp.
+struct KeywordEntry {
+    const char* text;
+    size_t length;
+    TokenType type;
 };
 
-// Define keywords according to the specification (update basic phase 2)
-vector<string> basic = {
-    "float", "int", "char", "void"
+constexpr KeywordEntry keywordList[] = {
+    {"if", 2, IF}, {"else", 4, ELSE}, {"while", 5, WHILE}, {"break", 5, BREAK},
+    {"main", 4, MAIN}, {"do", 2, DO}, {"return", 6, RETURN},
+    {"float", 5, BASIC}, {"int", 3, BASIC}, {"char", 4, BASIC}, {"void", 4, BASIC},
+    {"switch", 6, KEYWORD}, {"case", 4, KEYWORD}, {"for", 3, KEYWORD},
+    {"goto", 4, KEYWORD}, {"unsigned", 8, KEYWORD}, {"continue", 8, KEYWORD}
 };
 
-vector<string> keywords = {
-    "switch", "case", "for", "goto", "unsigned", "continue",
-    "do" // add keywords for phase 2
+const size_t KEYWORD_TABLE_SIZE = 32;
+const size_t KEYWORD_MIN_LENGTH = 2;
+const size_t KEYWORD_MAX_LENGTH = 8;
+
+constexpr size_t keywordHash(size_t length, unsigned char first, unsigned char last) {
+    return (length + first * 8u + last * 7u) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+struct KeywordTable {
+    KeywordEntry slot[KEYWORD_TABLE_SIZE];
+    bool collision;
 };
 
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable t{};
+    for (const KeywordEntry& entry : keywordList) {
+        size_t h = keywordHash(entry.length, entry.text[0], entry.text[entry.length - 1]);
+        if (t.slot[h].length != 0) t.collision = true;
+        t.slot[h] = entry;
+    }
+    return t;
+}
+
+constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(!keywordTable.collision, "keywordHash() is no longer perfect, pick new multipliers");
+
+// Map a lexeme to its keyword/basic-type token, or IDENTIFIER if it is not reserved
+TokenType lookupKeyword(const char* lexeme, size_t length) {
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH) return IDENTIFIER;
+    const KeywordEntry& entry = keywordTable.slot[keywordHash(length, lexeme[0], lexeme[length - 1])];
+    if (entry.length == length && memcmp(entry.text, lexeme, length) == 0) {
+        return entry.type;
+    }
+    return IDENTIFIER;
+}
+
+TokenType lookupKeyword(const string& lexeme) {
+    return lookupKeyword(lexeme.data(), lexeme.length());
+}
+
 // Function to check if a lexeme is a basic type
 bool isBasicType(const string& lexeme) {
-    for (const string& type : basic) {
-        if (lexeme == type) return true;
-    }
-    return false;
+    return lookupKeyword(lexeme) == BASIC;
 }
 // Function to check if a lexeme is a keyword
 bool isKeyword(const string& lexeme) {
-    for (const string& keyword : keywords) {
-        if (lexeme == keyword) return true;
-    }
-    return false;
+    return lookupKeyword(lexeme) == KEYWORD;
 }
-// Function to check if a lexeme is a basic type
+// Function to check if a lexeme is the return keyword
 bool isReturn(const string& lexeme) {
-    return lexeme == "return";
+    return lookupKeyword(lexeme) == RETURN;
 }
 
-// Lexical analyzer function
-vector<pair<TokenType, string>> lexer(const string& code, SymbolTable& symbol_table) {
-    vector<pair<TokenType, string>> tokens;
-    string currentToken;
-    int i = 0;
+// Lexical analyzer function (original if/else cascade, kept for cross-checking the table lexer)
+vector<Token> lexerCascade(string_view code) {
+    vector<Token> tokens;
+    size_t i = 0;
+    size_t lineStart = 0;
     int line = 1;
-    int column = 1;
 
     while (i < code.length()) {
         char ch = code[i];
-        int start_column = column;
+        size_t start = i;
+        int token_start = (int)(start - lineStart) + 1; // column of the token
 
         if (ch == '\n') {
           line++;
-          column = 1;
           i++;
+          lineStart = i;
+          continue;
         }
 
         // Skip whitespace
         if (isspace(ch)) {
-            column++;
             i++;
             continue;
         }
 
         // Check for comments (//)
         if (i + 1 < code.length() && code[i] == '/' && code[i + 1] == '/') {
-            int token_start = column;
-            string comment;
-            comment += "//";
             i += 2;
             while (i < code.length() && code[i] != '\n') {
-                comment += code[i];
                 i++;
             }
-            if (i < code.length() && code[i] == '\n') {
-                comment += '\n';
+            bool endsLine = i < code.length() && code[i] == '\n';
+            if (endsLine) {
                 i++;
             }
-            tokens.push_back({COMMENT, comment});
-            symbol_table.insert(comment, "COMMENT", comment, line, token_start, comment.length());
+            tokens.push_back(Token(COMMENT, start, i - start, line, token_start));
+            if (endsLine) {
+                line++;
+                lineStart = i;
+            }
             continue;
         }
 
         // Handle numbers (integers and reals)
         if (isdigit(ch) || (ch == '.' && i + 1 < code.length() && isdigit(code[i + 1]))) {
-            string number;
-            int token_start = column;
             bool isReal = false;
 
             // Handle leading digits
             while (i < code.length() && isdigit(code[i])) {
-                number += code[i];
                 i++;
-                column++;
             }
 
-            // Check for decimal point
+            // Check for decimal point (also covers numbers that begin with a dot)
             if (i < code.length() && code[i] == '.') {
                 isReal = true;
-                number += code[i];
                 i++;
-                column++;
 
                 while(i < code.length() && isdigit(code[i])) {
-                    number += code[i];
                     i++;
                 }
             }
-            // Handle numbers begin with dot
-            if (number.empty() && i < code.length() && code[i] == '.') {
-                isReal = true;
-                number = "0.";
-                i++;
-
-                while (i < code.length() && isdigit(code[i])) {
-                    number += code[i];
-                    i++;
-                }
-            }
-            tokens.push_back({isReal ? REAL : INTEGER, number});
-            symbol_table.insert(number, "INTEGER", number, line, token_start, number.length());
+            tokens.push_back(Token(isReal ? REAL : INTEGER, start, i - start, line, token_start));
             continue;
         }
         // Handle identifiers
         if (isalpha(ch)) {
-            string identifier;
-            int token_start = column;
-            identifier += ch;
             i++;
             while (i < code.length() && (isalnum(code[i]))) {
-                identifier += code[i];
                 i++;
-                column++;
-            }
-            if (identifier == "if") {
-                tokens.push_back({IF, identifier});
-                symbol_table.insert(identifier, "IF", identifier, line, token_start, identifier.length());
-            } else if (identifier == "else") {
-                tokens.push_back({ELSE, identifier});
-                symbol_table.insert(identifier, "ELSE", identifier, line, token_start, identifier.length());
-            } else if (identifier == "while") {
-                tokens.push_back({WHILE, identifier});
-                symbol_table.insert(identifier, "WHILE", identifier, line, token_start, identifier.length());
-            } else if (identifier == "break") {
-                tokens.push_back({BREAK, identifier});
-                symbol_table.insert(identifier, "BREAK", identifier, line, token_start, identifier.length());
-            } else if (identifier == "main") {
-                tokens.push_back({MAIN, identifier});
-                symbol_table.insert(identifier, "MAIN", identifier, line, token_start, identifier.length());
-            } else if (identifier == "do") {
-                tokens.push_back({DO, identifier});
-                symbol_table.insert(identifier, "DO", identifier, line, token_start, identifier.length());
-            } else if (isBasicType(identifier)) {
-                tokens.push_back({BASIC, identifier});
-                symbol_table.insert(identifier, "BASIC", identifier, line, token_start, identifier.length());
-            } else if (isReturn(identifier)) {
-                tokens.push_back({RETURN, identifier});
-                symbol_table.insert(identifier, "RETURN", identifier, line, token_start, identifier.length());
-            } else if (isKeyword(identifier)) {
-                tokens.push_back({KEYWORD, identifier});
-                symbol_table.insert(identifier, "KEYWORD", identifier, line, token_start, identifier.length());
-            } else {
-                tokens.push_back({IDENTIFIER, identifier});
-                symbol_table.insert(identifier, "IDENTIFIER", identifier, line, token_start, identifier.length());
             }
+            TokenType type = lookupKeyword(code.data() + start, i - start);
+            tokens.push_back(Token(type, start, i - start, line, token_start));
             continue;
         }
 
         // Handle delimiters and operators
-        int token_start = column;
+        TokenType type = INVALID;
         if (ch == '(') {
-          tokens.push_back({LEFT_PAREN, "("});
-          symbol_table.insert("(", "LEFT_PAREN", "(", line, token_start, 1);
-          } else if (ch == ')') {
-          tokens.push_back({RIGHT_PAREN, ")"});
-          symbol_table.insert(")", "RIGHT_PAREN", ")", line, token_start, 1);
+          type = LEFT_PAREN;
+        } else if (ch == ')') {
+          type = RIGHT_PAREN;
         } else if (ch == '[') {
-          tokens.push_back({LEFT_BRACKET, "["});
-          symbol_table.insert("[", "LEFT_BRACKET", "[", line, token_start, 1);
+          type = LEFT_BRACKET;
         } else if (ch == ']') {
-          tokens.push_back({RIGHT_BRACKET, "]"});
-          symbol_table.insert("]", "RIGHT_BRACKET", "]", line, token_start, 1);
+          type = RIGHT_BRACKET;
         } else if (ch == '{') {
-          tokens.push_back({LEFT_BRACE, "{"});
-          symbol_table.insert("{", "LEFT_BRACE", "}", line, token_start, 1);
+          type = LEFT_BRACE;
         }
         else if (ch == '}') {
-          tokens.push_back({RIGHT_BRACE, "}"});
-          symbol_table.insert("}", "RIGHT_BRACE", "}", line, token_start, 1);
+          type = RIGHT_BRACE;
         }
         else if (ch == ';') {
-          tokens.push_back({SEMICOLON, ";"});
-          symbol_table.insert(";", "SEMICOLON", ";", line, token_start, 1);
+          type = SEMICOLON;
         }
         else if (ch == ',') {
-          tokens.push_back({COMMA, ","});
-          symbol_table.insert(",", "COMMA", ",", line, token_start, 1);
+          type = COMMA;
         }
         else if (ch == '+') {
             if (i + 1 < code.length() && code[i + 1] == '+') {
-                tokens.push_back({INCREMENT, "++"});
-                symbol_table.insert("++", "INCREMENT", "++", line, token_start, 2);
+                type = INCREMENT;
                 i++;
             } else {
-                tokens.push_back({PLUS, "+"});
-                symbol_table.insert("+", "PLUS", "+", line, token_start, 1);
+                type = PLUS;
             }
         }
         else if (ch == '-') {
             if (i + 1 < code.length() && code[i + 1] == '-') {
-                tokens.push_back({DECREMENT, "--"});
-                symbol_table.insert("--", "DECREMENT", "--", line, token_start, 2);
+                type = DECREMENT;
                 i++;
             } else {
-                tokens.push_back({MINUS, "-"});
-                symbol_table.insert("-", "MINUS", "-", line, token_start, 1);
+                type = MINUS;
             }
         }
         else if (ch == '*') {
-          tokens.push_back({MULTIPLY, "*"});
-          symbol_table.insert("*", "MULTIPLY", "*", line, token_start, 1);
+          type = MULTIPLY;
         }
         else if (ch == '/') {
-          tokens.push_back({DIVIDE, "/"});
-          symbol_table.insert("/", "DIVIDE", "/", line, token_start, 1);
+          type = DIVIDE;
         }
         else if (ch == '%') {
-          tokens.push_back({MODULUS, "%"});
-          symbol_table.insert("%", "MODULUS", "%", line, token_start, 1);
+          type = MODULUS;
         }
         else if (ch == '<') {
             if (i + 1 < code.length() && code[i + 1] == '=') {
-                tokens.push_back({LESS_THAN_EQ, "<="});
-                symbol_table.insert("<=", "LESS_THAN_EQ", "<=", line, token_start, 2);
+                type = LESS_THAN_EQ;
                 i++;
             } else {
-                tokens.push_back({LESS_THAN, "<"});
-                symbol_table.insert("<", "LESS_THAN", "<", line, token_start, 1);
+                type = LESS_THAN;
             }
         }
         else if (ch == '>') {
             if (i + 1 < code.length() && code[i + 1] == '=') {
-                tokens.push_back({GREATER_THAN_EQ, ">="});
-                symbol_table.insert(">=", "GREATER_THAN_EQ", ">=", line, token_start, 2);
+                type = GREATER_THAN_EQ;
                 i++;
             } else {
-                tokens.push_back({GREATER_THAN, ">"});
-                symbol_table.insert(">", "GREATER_THAN", ">", line, token_start, 1);
+                type = GREATER_THAN;
             }
         }
         else if (ch == '=') {
             if (i + 1 < code.length() && code[i + 1] == '=') {
-                tokens.push_back({LOGIC_EQUAL, "=="});
-                symbol_table.insert("=", "LOGIC_EQUAL", "=", line, token_start, 2);
+                type = LOGIC_EQUAL;
                 i++;
             } else {
-                tokens.push_back({ASSIGNMENT, "="});
-                symbol_table.insert("=", "ASSIGNMENT", "=", line, token_start, 1);
+                type = ASSIGNMENT;
             }
         }
         else if (ch == '&') {
             if (i + 1 < code.length() && code[i + 1] == '&') {
-                tokens.push_back({LOGIC_AND, "&&"});
-                symbol_table.insert("&&", "LOGIC_AND", "&&", line, token_start, 2);
+                type = LOGIC_AND;
                 i++;
             } else {
-                tokens.push_back({BIT_AND, "&"});
-                symbol_table.insert("&", "BIT_AND", "&", line, token_start, 1);
+                type = BIT_AND;
             }
         }
         else if (ch == '|') {
             if (i + 1 < code.length() && code[i + 1] == '|') {
-                tokens.push_back({LOGIC_OR, "||"});
-                symbol_table.insert("||", "LOGIC_OR", "||", line, token_start, 2);
+                type = LOGIC_OR;
                 i++;
             } else {
-                tokens.push_back({BIT_OR, "|"});
-                symbol_table.insert("|", "BIT_OR", "|", line, token_start, 1);
+                type = BIT_OR;
             }
         }
         else if (ch == '!'){
             if (i + 1 < code.length() && code[i + 1] == '=') {
-                tokens.push_back({LOGIC_NOT_EQUAL, "!="});
-                symbol_table.insert("!=", "LOGIC_NOT_EQUAL", "!=", line, token_start, 2);
+                type = LOGIC_NOT_EQUAL;
                 i++;
             } else {
-                tokens.push_back({LOGIC_NOT, "!"});
-                symbol_table.insert("!", "LOGIC_NOT", "!", line, token_start, 1);
+                type = LOGIC_NOT;
             }
         }
-        else if (ch != '.') { // Skip standalone dots as they're handled in number parsing
-            tokens.push_back({INVALID, string(1, ch)});
-            symbol_table.insert(string(1, ch), "INVALID", string(1, ch), line, token_start, string(1, ch).length());
-        }
         i++;
+        if (ch != '.') { // Skip standalone dots as they're handled in number parsing
+            tokens.push_back(Token(type, start, i - start, line, token_start));
+        }
+    }
+    return tokens;
+}
+
+// ---------------------------------------------------------------------------
+// Table-driven DFA lexer
+//
+// Every byte goes through one charClass[] load and one transition[][] load.
+// A token ends at the first byte that sends the DFA to S_DEAD; every other
+// state is accepting, so there is no backtracking. The token type comes from
+// the state we stopped in (identifiers still go through the keyword check).
+// ---------------------------------------------------------------------------
+
+// Character classes
+enum CharClass : uint8_t {
+    CC_OTHER, CC_SPACE, CC_NEWLINE, CC_ALPHA, CC_DIGIT, CC_DOT, CC_SLASH,
+    CC_PLUS, CC_MINUS, CC_LESS, CC_GREATER, CC_EQUAL, CC_AMP, CC_BAR, CC_BANG,
+    CC_LPAREN, CC_RPAREN, CC_LBRACKET, CC_RBRACKET, CC_LBRACE, CC_RBRACE,
+    CC_SEMICOLON, CC_COMMA, CC_STAR, CC_PERCENT,
+    NUM_CHAR_CLASSES
+};
+
+// DFA states (S_DEAD must be 0 so the transition table defaults to it)
+enum LexState : uint8_t {
+    S_DEAD, S_START, S_SPACE, S_NEWLINE, S_IDENT, S_INT, S_REAL, S_DOT,
+    S_SLASH, S_COMMENT, S_COMMENT_END,
+    S_PLUS, S_INCREMENT, S_MINUS, S_DECREMENT, S_LESS, S_LESS_EQ,
+    S_GREATER, S_GREATER_EQ, S_ASSIGN, S_EQUAL, S_AMP, S_AND, S_BAR, S_OR,
+    S_BANG, S_NOT_EQUAL, S_LPAREN, S_RPAREN, S_LBRACKET, S_RBRACKET,
+    S_LBRACE, S_RBRACE, S_SEMICOLON, S_COMMA, S_STAR, S_PERCENT, S_INVALID,
+    NUM_LEX_STATES
+};
+
+struct LexerTables {
+    uint8_t charClass[256];
+    uint8_t transition[NUM_LEX_STATES][NUM_CHAR_CLASSES];
+    int8_t accept[NUM_LEX_STATES]; // TokenType for the state, -1 = skip (whitespace, lone '.')
+};
+
+constexpr LexerTables buildLexerTables() {
+    LexerTables t{};
+
+    // Character class table (same classification as isspace/isalpha/isdigit in the "C" locale)
+    for (int c = 0; c < 256; c++) t.charClass[c] = CC_OTHER;
+    t.charClass[(int)' '] = t.charClass[(int)'\t'] = t.charClass[(int)'\v'] = CC_SPACE;
+    t.charClass[(int)'\f'] = t.charClass[(int)'\r'] = CC_SPACE;
+    t.charClass[(int)'\n'] = CC_NEWLINE;
+    for (int c = 'a'; c <= 'z'; c++) t.charClass[c] = CC_ALPHA;
+    for (int c = 'A'; c <= 'Z'; c++) t.charClass[c] = CC_ALPHA;
+    for (int c = '0'; c <= '9'; c++) t.charClass[c] = CC_DIGIT;
+    t.charClass[(int)'.'] = CC_DOT;       t.charClass[(int)'/'] = CC_SLASH;
+    t.charClass[(int)'+'] = CC_PLUS;      t.charClass[(int)'-'] = CC_MINUS;
+    t.charClass[(int)'<'] = CC_LESS;      t.charClass[(int)'>'] = CC_GREATER;
+    t.charClass[(int)'='] = CC_EQUAL;     t.charClass[(int)'&'] = CC_AMP;
+    t.charClass[(int)'|'] = CC_BAR;       t.charClass[(int)'!'] = CC_BANG;
+    t.charClass[(int)'('] = CC_LPAREN;    t.charClass[(int)')'] = CC_RPAREN;
+    t.charClass[(int)'['] = CC_LBRACKET;  t.charClass[(int)']'] = CC_RBRACKET;
+    t.charClass[(int)'{'] = CC_LBRACE;    t.charClass[(int)'}'] = CC_RBRACE;
+    t.charClass[(int)';'] = CC_SEMICOLON; t.charClass[(int)','] = CC_COMMA;
+    t.charClass[(int)'*'] = CC_STAR;      t.charClass[(int)'%'] = CC_PERCENT;
+
+    // Transitions out of the start state
+    uint8_t* start = t.transition[S_START];
+    start[CC_OTHER] = S_INVALID;      start[CC_SPACE] = S_SPACE;
+    start[CC_NEWLINE] = S_NEWLINE;    start[CC_ALPHA] = S_IDENT;
+    start[CC_DIGIT] = S_INT;          start[CC_DOT] = S_DOT;
+    start[CC_SLASH] = S_SLASH;        start[CC_PLUS] = S_PLUS;
+    start[CC_MINUS] = S_MINUS;        start[CC_LESS] = S_LESS;
+    start[CC_GREATER] = S_GREATER;    start[CC_EQUAL] = S_ASSIGN;
+    start[CC_AMP] = S_AMP;            start[CC_BAR] = S_BAR;
+    start[CC_BANG] = S_BANG;          start[CC_LPAREN] = S_LPAREN;
+    start[CC_RPAREN] = S_RPAREN;      start[CC_LBRACKET] = S_LBRACKET;
+    start[CC_RBRACKET] = S_RBRACKET;  start[CC_LBRACE] = S_LBRACE;
+    start[CC_RBRACE] = S_RBRACE;      start[CC_SEMICOLON] = S_SEMICOLON;
+    start[CC_COMMA] = S_COMMA;        start[CC_STAR] = S_STAR;
+    start[CC_PERCENT] = S_PERCENT;
+
+    // Multi-character lexemes
+    t.transition[S_SPACE][CC_SPACE] = S_SPACE;
+    t.transition[S_IDENT][CC_ALPHA] = S_IDENT;
+    t.transition[S_IDENT][CC_DIGIT] = S_IDENT;
+    t.transition[S_INT][CC_DIGIT] = S_INT;
+    t.transition[S_INT][CC_DOT] = S_REAL;
+    t.transition[S_DOT][CC_DIGIT] = S_REAL;
+    t.transition[S_REAL][CC_DIGIT] = S_REAL;
+    t.transition[S_SLASH][CC_SLASH] = S_COMMENT;
+    for (int c = 0; c < NUM_CHAR_CLASSES; c++) t.transition[S_COMMENT][c] = S_COMMENT;
+    t.transition[S_COMMENT][CC_NEWLINE] = S_COMMENT_END; // comment keeps its newline
+    t.transition[S_PLUS][CC_PLUS] = S_INCREMENT;
+    t.transition[S_MINUS][CC_MINUS] = S_DECREMENT;
+    t.transition[S_LESS][CC_EQUAL] = S_LESS_EQ;
+    t.transition[S_GREATER][CC_EQUAL] = S_GREATER_EQ;
+    t.transition[S_ASSIGN][CC_EQUAL] = S_EQUAL;
+    t.transition[S_AMP][CC_AMP] = S_AND;
+    t.transition[S_BAR][CC_BAR] = S_OR;
+    t.transition[S_BANG][CC_EQUAL] = S_NOT_EQUAL;
+
+    // Token produced by each final state
+    for (int s = 0; s < NUM_LEX_STATES; s++) t.accept[s] = -1;
+    t.accept[S_IDENT] = IDENTIFIER;      t.accept[S_INT] = INTEGER;
+    t.accept[S_REAL] = REAL;             t.accept[S_SLASH] = DIVIDE;
+    t.accept[S_COMMENT] = COMMENT;       t.accept[S_COMMENT_END] = COMMENT;
+    t.accept[S_PLUS] = PLUS;             t.accept[S_INCREMENT] = INCREMENT;
+    t.accept[S_MINUS] = MINUS;           t.accept[S_DECREMENT] = DECREMENT;
+    t.accept[S_LESS] = LESS_THAN;        t.accept[S_LESS_EQ] = LESS_THAN_EQ;
+    t.accept[S_GREATER] = GREATER_THAN;  t.accept[S_GREATER_EQ] = GREATER_THAN_EQ;
+    t.accept[S_ASSIGN] = ASSIGNMENT;     t.accept[S_EQUAL] = LOGIC_EQUAL;
+    t.accept[S_AMP] = BIT_AND;           t.accept[S_AND] = LOGIC_AND;
+    t.accept[S_BAR] = BIT_OR;            t.accept[S_OR] = LOGIC_OR;
+    t.accept[S_BANG] = LOGIC_NOT;        t.accept[S_NOT_EQUAL] = LOGIC_NOT_EQUAL;
+    t.accept[S_LPAREN] = LEFT_PAREN;     t.accept[S_RPAREN] = RIGHT_PAREN;
+    t.accept[S_LBRACKET] = LEFT_BRACKET; t.accept[S_RBRACKET] = RIGHT_BRACKET;
+    t.accept[S_LBRACE] = LEFT_BRACE;     t.accept[S_RBRACE] = RIGHT_BRACE;
+    t.accept[S_SEMICOLON] = SEMICOLON;   t.accept[S_COMMA] = COMMA;
+    t.accept[S_STAR] = MULTIPLY;         t.accept[S_PERCENT] = MODULUS;
+    t.accept[S_INVALID] = INVALID;
+    return t;
+}
+
+constexpr LexerTables lexerTables = buildLexerTables();
+
+// Pull-based table lexer: each next() call runs the DFA over one token of the
+// source buffer, so callers can parse without materializing the token vector.
+class Lexer {
+    string_view source;
+    size_t pos;
+    size_t end;
+    size_t lineStart;
+    int line;
+
+public:
+    explicit Lexer(string_view source)
+        : source(source), pos(0), end(source.length()), lineStart(0), line(1) {}
+
+    // Lex only [begin, end) of the source. The range must start at a line start,
+    // lines are counted from 1.
+    Lexer(string_view source, size_t begin, size_t end)
+        : source(source), pos(begin), end(end), lineStart(begin), line(1) {}
+
+    // Number of newlines consumed so far
+    int linesConsumed() const { return line - 1; }
+
+    // Produce the next token, returns false once the input is used up
+    bool next(Token& token) {
+        const unsigned char* src = reinterpret_cast<const unsigned char*>(source.data());
+        size_t n = end;
+
+        while (pos < n) {
+            // Whitespace (newlines included) is skipped in bulk
+            uint8_t firstClass = lexerTables.charClass[src[pos]];
+            if (firstClass == CC_SPACE || firstClass == CC_NEWLINE) {
+                SpaceRun run = lexerScanners.skipSpace(src, pos, n);
+                if (run.newlines) {
+                    line += run.newlines;
+                    lineStart = run.lastNewline + 1;
+                }
+                pos = run.end;
+                continue;
+            }
+
+            size_t start = pos;
+            int state = S_START;
+
+            // Run the DFA until it dies
+            while (pos < n) {
+                int next = lexerTables.transition[state][lexerTables.charClass[src[pos]]];
+                if (next == S_DEAD) break;
+                state = next;
+                pos++;
+
+                // Self-looping states jump over the rest of their run with the vector kernels
+                switch (state) {
+                    case S_IDENT: pos = lexerScanners.scanAlnum(src, pos, n); break;
+                    case S_INT:
+                    case S_REAL: pos = lexerScanners.scanDigits(src, pos, n); break;
+                    case S_COMMENT: pos = lexerScanners.findNewline(src, pos, n); break;
+                    default: break;
+                }
+            }
+
+            int column = (int)(start - lineStart) + 1;
+            int tokenLine = line;
+            if (state == S_NEWLINE || state == S_COMMENT_END) {
+                line++;
+                lineStart = pos;
+            }
+
+            int type = lexerTables.accept[state];
+            if (type < 0) continue; // whitespace or a lone '.'
+
+            TokenType tokenType = (TokenType)type;
+            if (tokenType == IDENTIFIER) {
+                tokenType = lookupKeyword(source.data() + start, pos - start);
+            }
+            token = Token(tokenType, start, pos - start, tokenLine, column);
+            return true;
+        }
+        return false;
+    }
+};
+
+// Table-driven lexer, produces the same token stream as lexerCascade
+vector<Token> lexerTable(string_view code) {
+    vector<Token> tokens;
+    Lexer lex(code);
+    Token token;
+    while (lex.next(token)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// Batched symbol table pass: the lexers only emit tokens, identifiers and
+// keywords are inserted here afterwards, in token order
+void insertIdentifiers(const Token* begin, const Token* end, string_view source,
+                       SymbolTable& symbol_table) {
+    for (const Token* token = begin; token != end; token++) {
+        if (token->type == IDENTIFIER || token->type == KEYWORD) {
+            Symbol lexeme = intern(token->text(source));
+            symbol_table.insert(lexeme, token->type, lexeme, token->line(), token->column(),
+                                token->length);
+        }
+    }
+}
+
+void insertIdentifiers(const vector<Token>& tokens, string_view source, SymbolTable& symbol_table) {
+    insertIdentifiers(tokens.data(), tokens.data() + tokens.size(), source, symbol_table);
+}
+
+// Parallel lexer. Tokens never cross a newline except a comment, which ends
+// with (and includes) its newline, so cutting the buffer right after a '\n'
+// never splits a token. Chunks are lexed on a small worker pool, then line
+// numbers are shifted by a prefix sum of each chunk's newline count and the
+// token arrays are concatenated. The result matches lexerTable() exactly.
+// No symbol table is touched here, so the workers share nothing.
+const size_t PARALLEL_LEX_MIN_CHUNK = 1 << 20; // below this a thread costs more than it saves
+
+vector<Token> lexerParallel(string_view code, unsigned threads = 0,
+                            size_t minChunk = PARALLEL_LEX_MIN_CHUNK) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    if (minChunk == 0) minChunk = 1;
+
+    // Oversplit a little so a slow chunk doesn't hold up the whole pool
+    size_t chunkCount = min<size_t>(threads * 4, max<size_t>(1, code.length() / minChunk));
+    if (chunkCount <= 1 || threads == 1) {
+        return lexerTable(code);
+    }
+
+    // Cut points, each one right after a newline
+    vector<size_t> cuts = {0};
+    for (size_t k = 1; k < chunkCount; k++) {
+        size_t target = max(cuts.back(), code.length() * k / chunkCount);
+        size_t nl = code.find('\n', target);
+        if (nl == string_view::npos) break;
+        if (nl + 1 > cuts.back()) cuts.push_back(nl + 1);
+    }
+    cuts.push_back(code.length());
+    chunkCount = cuts.size() - 1;
+
+    vector<vector<Token>> chunkTokens(chunkCount);
+    vector<int> chunkLines(chunkCount);
+    auto runPool = [&](auto work) {
+        atomic<size_t> nextChunk(0);
+        vector<thread> pool;
+        unsigned workers = (unsigned)min<size_t>(threads, chunkCount);
+        for (unsigned w = 0; w < workers; w++) {
+            pool.emplace_back([&]() {
+                for (size_t c = nextChunk++; c < chunkCount; c = nextChunk++) work(c);
+            });
+        }
+        for (thread& t : pool) t.join();
+    };
+
+    // Pass 1: lex every chunk on its own, lines counted from 1
+    runPool([&](size_t c) {
+        Lexer lex(code, cuts[c], cuts[c + 1]);
+        Token token;
+        while (lex.next(token)) chunkTokens[c].push_back(token);
+        chunkLines[c] = lex.linesConsumed();
+    });
+
+    // Prefix sums: where each chunk's tokens go and which line it starts on
+    vector<size_t> firstToken(chunkCount + 1, 0);
+    vector<uint32_t> firstLine(chunkCount, 1);
+    for (size_t c = 0; c < chunkCount; c++) {
+        firstToken[c + 1] = firstToken[c] + chunkTokens[c].size();
+        if (c + 1 < chunkCount) firstLine[c + 1] = firstLine[c] + chunkLines[c];
+    }
+
+    // Pass 2: shift line numbers and copy into the final array
+    vector<Token> tokens(firstToken[chunkCount]);
+    runPool([&](size_t c) {
+        uint32_t lineOffset = firstLine[c] - 1;
+        Token* out = tokens.data() + firstToken[c];
+        for (Token token : chunkTokens[c]) {
+            if (lineOffset) token.position = Token::packPosition(token.line() + lineOffset, token.column());
+            *out++ = token;
+        }
+        vector<Token>().swap(chunkTokens[c]);
+    });
+    return tokens;
+}
+
+// Which lexer implementation to run
+enum class LexerMode { CASCADE, TABLE, PARALLEL };
+
+vector<Token> lexer(string_view code, SymbolTable& symbol_table,
+                    LexerMode mode = LexerMode::TABLE) {
+    vector<Token> tokens;
+    if (mode == LexerMode::CASCADE) {
+        tokens = lexerCascade(code);
+    } else if (mode == LexerMode::PARALLEL) {
+        tokens = lexerParallel(code);
+    } else {
+        tokens = lexerTable(code);
     }
+    insertIdentifiers(tokens, code, symbol_table);
     return tokens;
 }
 
 // Function to print tokens
-void printTokens(const vector<pair<TokenType, string>>& tokens) {
-    for (const auto& token : tokens) {
+void printTokens(const vector<Token>& tokens, string_view source) {
+    for (const Token& token : tokens) {
         string tokenType;
-        switch (token.first) {
+        switch (token.type) {
             case RETURN: tokenType = "Return"; break;
             case BASIC: tokenType = "Basic"; break;
             case IF: tokenType = "If"; break;
@@ -356,7 +626,7 @@ void printTokens(const vector<pair<TokenType, string>>& tokens) {
             case DO: tokenType = "Do"; break;
             case INVALID: tokenType = "INVALID"; break;
         }
-        cout << tokenType << ": " << token.second << endl;
+        cout << tokenType << ": " << token.text(source) << endl;
 
         // Insert into symbol table
     }
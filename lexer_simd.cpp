@@ -0,0 +1,250 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEXER_SIMD_X86 1
+#endif
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Vectorized scanning kernels for the lexer's long runs: whitespace,
+// identifier characters, digits and comment bodies. Each kernel has a scalar
+// version, an SSE2 version (16 bytes per step) and an AVX2 version (32 bytes
+// per step); lexerScanners picks one set at startup based on the CPU.
+// All kernels take [pos, n) and return the index of the first byte that is
+// not part of the run.
+// ---------------------------------------------------------------------------
+
+// Whitespace run result: newlines inside it move the line counter
+struct SpaceRun {
+    size_t end;          // first non-whitespace byte
+    size_t newlines;     // '\n' bytes skipped
+    size_t lastNewline;  // index of the last '\n' skipped (valid if newlines > 0)
+};
+
+inline bool scalarIsSpace(unsigned char c) { return c == ' ' || (unsigned char)(c - '\t') <= 4; }
+inline bool scalarIsDigit(unsigned char c) { return (unsigned char)(c - '0') <= 9; }
+inline bool scalarIsAlnum(unsigned char c) {
+    return scalarIsDigit(c) || (unsigned char)((c | 0x20) - 'a') <= 25;
+}
+
+// Scalar fallbacks (also used for the tails the vector loops leave behind)
+SpaceRun skipSpaceScalar(const unsigned char* src, size_t pos, size_t n) {
+    SpaceRun run = {pos, 0, 0};
+    while (run.end < n && scalarIsSpace(src[run.end])) {
+        if (src[run.end] == '\n') {
+            run.newlines++;
+            run.lastNewline = run.end;
+        }
+        run.end++;
+    }
+    return run;
+}
+
+size_t scanAlnumScalar(const unsigned char* src, size_t pos, size_t n) {
+    while (pos < n && scalarIsAlnum(src[pos])) pos++;
+    return pos;
+}
+
+size_t scanDigitsScalar(const unsigned char* src, size_t pos, size_t n) {
+    while (pos < n && scalarIsDigit(src[pos])) pos++;
+    return pos;
+}
+
+size_t findNewlineScalar(const unsigned char* src, size_t pos, size_t n) {
+    if (pos >= n) return n;
+    const void* hit = memchr(src + pos, '\n', n - pos);
+    return hit ? (size_t)(static_cast<const unsigned char*>(hit) - src) : n;
+}
+
+#ifdef LEXER_SIMD_X86
+
+// SSE2: "x - lo <= span" as an unsigned byte compare (min(d, span) == d)
+inline __m128i sse2InRange(__m128i x, char lo, char span) {
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(span)), d);
+}
+
+inline __m128i sse2SpaceMask(__m128i x) {
+    return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), sse2InRange(x, '\t', 4));
+}
+
+inline __m128i sse2AlnumMask(__m128i x) {
+    __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+    return _mm_or_si128(sse2InRange(x, '0', 9), sse2InRange(lower, 'a', 25));
+}
+
+SpaceRun skipSpaceSSE2(const unsigned char* src, size_t pos, size_t n) {
+    SpaceRun run = {pos, 0, 0};
+    while (run.end + 16 <= n) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + run.end));
+        uint32_t space = (uint32_t)_mm_movemask_epi8(sse2SpaceMask(x));
+        uint32_t newline = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+        uint32_t stop = ~space & 0xFFFF;
+        if (stop) {
+            uint32_t taken = (1u << __builtin_ctz(stop)) - 1;
+            newline &= taken;
+            if (newline) {
+                run.newlines += __builtin_popcount(newline);
+                run.lastNewline = run.end + 31 - __builtin_clz(newline);
+            }
+            run.end += __builtin_ctz(stop);
+            return run;
+        }
+        if (newline) {
+            run.newlines += __builtin_popcount(newline);
+            run.lastNewline = run.end + 31 - __builtin_clz(newline);
+        }
+        run.end += 16;
+    }
+    SpaceRun tail = skipSpaceScalar(src, run.end, n);
+    if (tail.newlines) {
+        run.newlines += tail.newlines;
+        run.lastNewline = tail.lastNewline;
+    }
+    run.end = tail.end;
+    return run;
+}
+
+size_t scanAlnumSSE2(const unsigned char* src, size_t pos, size_t n) {
+    while (pos + 16 <= n) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        uint32_t stop = ~(uint32_t)_mm_movemask_epi8(sse2AlnumMask(x)) & 0xFFFF;
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 16;
+    }
+    return scanAlnumScalar(src, pos, n);
+}
+
+size_t scanDigitsSSE2(const unsigned char* src, size_t pos, size_t n) {
+    while (pos + 16 <= n) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        uint32_t stop = ~(uint32_t)_mm_movemask_epi8(sse2InRange(x, '0', 9)) & 0xFFFF;
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 16;
+    }
+    return scanDigitsScalar(src, pos, n);
+}
+
+size_t findNewlineSSE2(const unsigned char* src, size_t pos, size_t n) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (pos + 16 <= n) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        uint32_t hit = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, newline));
+        if (hit) return pos + __builtin_ctz(hit);
+        pos += 16;
+    }
+    return findNewlineScalar(src, pos, n);
+}
+
+// AVX2 versions, compiled for AVX2 only inside these functions
+__attribute__((target("avx2")))
+inline __m256i avx2InRange(__m256i x, char lo, char span) {
+    __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(span)), d);
+}
+
+__attribute__((target("avx2")))
+SpaceRun skipSpaceAVX2(const unsigned char* src, size_t pos, size_t n) {
+    SpaceRun run = {pos, 0, 0};
+    while (run.end + 32 <= n) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + run.end));
+        __m256i spaceMask = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                                            avx2InRange(x, '\t', 4));
+        uint32_t space = (uint32_t)_mm256_movemask_epi8(spaceMask);
+        uint32_t newline = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')));
+        uint32_t stop = ~space;
+        if (stop) {
+            int len = __builtin_ctz(stop);
+            newline &= len ? (0xFFFFFFFFu >> (32 - len)) : 0;
+            if (newline) {
+                run.newlines += __builtin_popcount(newline);
+                run.lastNewline = run.end + 31 - __builtin_clz(newline);
+            }
+            run.end += len;
+            return run;
+        }
+        if (newline) {
+            run.newlines += __builtin_popcount(newline);
+            run.lastNewline = run.end + 31 - __builtin_clz(newline);
+        }
+        run.end += 32;
+    }
+    SpaceRun tail = skipSpaceSSE2(src, run.end, n);
+    if (tail.newlines) {
+        run.newlines += tail.newlines;
+        run.lastNewline = tail.lastNewline;
+    }
+    run.end = tail.end;
+    return run;
+}
+
+__attribute__((target("avx2")))
+size_t scanAlnumAVX2(const unsigned char* src, size_t pos, size_t n) {
+    while (pos + 32 <= n) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        __m256i alnum = _mm256_or_si256(avx2InRange(x, '0', 9), avx2InRange(lower, 'a', 25));
+        uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(alnum);
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return scanAlnumSSE2(src, pos, n);
+}
+
+__attribute__((target("avx2")))
+size_t scanDigitsAVX2(const unsigned char* src, size_t pos, size_t n) {
+    while (pos + 32 <= n) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(avx2InRange(x, '0', 9));
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return scanDigitsSSE2(src, pos, n);
+}
+
+__attribute__((target("avx2")))
+size_t findNewlineAVX2(const unsigned char* src, size_t pos, size_t n) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (pos + 32 <= n) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        uint32_t hit = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, newline));
+        if (hit) return pos + __builtin_ctz(hit);
+        pos += 32;
+    }
+    return findNewlineSSE2(src, pos, n);
+}
+
+#endif // LEXER_SIMD_X86
+
+// One set of kernels, chosen once per process
+struct LexerScanners {
+    SpaceRun (*skipSpace)(const unsigned char*, size_t, size_t);
+    size_t (*scanAlnum)(const unsigned char*, size_t, size_t);
+    size_t (*scanDigits)(const unsigned char*, size_t, size_t);
+    size_t (*findNewline)(const unsigned char*, size_t, size_t);
+    const char* name;
+};
+
+enum class ScannerLevel { AUTO, SCALAR, SSE2, AVX2 };
+
+LexerScanners selectLexerScanners(ScannerLevel level = ScannerLevel::AUTO) {
+#ifdef LEXER_SIMD_X86
+    if (level == ScannerLevel::AUTO) {
+        __builtin_cpu_init();
+        level = __builtin_cpu_supports("avx2") ? ScannerLevel::AVX2 : ScannerLevel::SSE2;
+    }
+    if (level == ScannerLevel::AVX2) {
+        return {skipSpaceAVX2, scanAlnumAVX2, scanDigitsAVX2, findNewlineAVX2, "avx2"};
+    }
+    if (level == ScannerLevel::SSE2) {
+        return {skipSpaceSSE2, scanAlnumSSE2, scanDigitsSSE2, findNewlineSSE2, "sse2"};
+    }
+#else
+    (void)level;
+#endif
+    return {skipSpaceScalar, scanAlnumScalar, scanDigitsScalar, findNewlineScalar, "scalar"};
+}
+
+LexerScanners lexerScanners = selectLexerScanners();
@@ -0,0 +1,107 @@
+#include "optimizer.h"
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Live variable analysis. A name is live at a point if some path from there
+// reads it before writing it. Per block:
+//
+//     out[b] = union of in[s] over the successors s
+//     in[b]  = reads[b] | (out[b] & ~writes[b])
+//
+// where reads[b] holds what b reads before writing it. Sets only grow, so a
+// worklist seeded in postorder (successors before predecessors) settles
+// after revisiting just the predecessors of blocks whose in[] changed.
+// Unreachable blocks stay empty: they have no reachable predecessors to
+// pass anything to.
+// ---------------------------------------------------------------------------
+
+Liveness::Liveness(const TACProgram& program, const ControlFlowGraph& cfg)
+    : program(program), cfg(cfg), words(0) {
+    findGlobalNames();
+    solve();
+}
+
+uint32_t Liveness::slot(TACOperand operand) const {
+    if (!operand.is(TACOperand::VARIABLE) && !operand.is(TACOperand::TEMP)) return NO_SLOT;
+    return slotOfName[nameIndex(operand)];
+}
+
+// Names read in a block before it writes them, numbered in name order
+void Liveness::findGlobalNames() {
+    vector<bool> global(nameCount(), false);
+    vector<BlockId> writtenIn(nameCount(), NO_BLOCK);
+    for (BlockId b : cfg.order) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            const TACInstruction& instruction = program.code[i];
+            forEachRead(instruction, [&](TACOperand name) {
+                if (writtenIn[nameIndex(name)] != b) global[nameIndex(name)] = true;
+            });
+            TACOperand written = writtenBy(instruction);
+            if (!written.none()) writtenIn[nameIndex(written)] = b;
+        }
+    }
+
+    slotOfName.assign(nameCount(), NO_SLOT);
+    for (uint32_t n = 0; n < nameCount(); n++) {
+        if (!global[n]) continue;
+        slotOfName[n] = (uint32_t)names.size();
+        names.push_back(n < program.variables.size() ? TACOperand::variable(n)
+                                                     : TACOperand::temp(n - (uint32_t)program.variables.size()));
+    }
+    words = (names.size() + 63) / 64;
+}
+
+void Liveness::solve() {
+    size_t count = cfg.size();
+    in.assign(count * words, 0);
+    out.assign(count * words, 0);
+    if (words == 0) return;
+
+    // What each block reads first (straight into in[]) and writes
+    vector<uint64_t> writes(count * words, 0);
+    for (BlockId b : cfg.order) {
+        uint64_t* reads = &in[b * words];
+        uint64_t* kills = &writes[b * words];
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            const TACInstruction& instruction = program.code[i];
+            forEachRead(instruction, [&](TACOperand name) {
+                uint32_t s = slot(name);
+                if (s != NO_SLOT && !(kills[s / 64] >> (s % 64) & 1)) reads[s / 64] |= 1ull << (s % 64);
+            });
+            uint32_t s = slot(writtenBy(instruction));
+            if (s != NO_SLOT) kills[s / 64] |= 1ull << (s % 64);
+        }
+    }
+
+    vector<BlockId> work(cfg.order.rbegin(), cfg.order.rend());
+    vector<bool> queued(count, false);
+    for (BlockId b : work) {
+        queued[b] = true;
+    }
+    for (size_t next = 0; next < work.size(); next++) {
+        BlockId b = work[next];
+        queued[b] = false;
+        uint64_t* exit = &out[b * words];
+        for (BlockId s : cfg.successors(b)) {
+            const uint64_t* entry = &in[s * words];
+            for (size_t w = 0; w < words; w++) {
+                exit[w] |= entry[w];
+            }
+        }
+        uint64_t* entry = &in[b * words];
+        const uint64_t* kills = &writes[b * words];
+        bool changed = false;
+        for (size_t w = 0; w < words; w++) {
+            uint64_t grown = entry[w] | (exit[w] & ~kills[w]);
+            changed |= grown != entry[w];
+            entry[w] = grown;
+        }
+        if (!changed) continue;
+        for (BlockId p : cfg.predecessors(b)) {
+            if (!queued[p] && cfg.reachable(p)) {
+                queued[p] = true;
+                work.push_back(p);
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "optimizer.h"
+#include "constant_propagation.cpp"
+#include "value_numbering.cpp"
+#include "liveness.cpp"
+#include "dead_code.cpp"
+#include "ssa.cpp"
+using namespace std;
+
+// optimizer_check.cpp includes this file for the passes and has its own main
+#ifndef OPTIMIZER_NO_MAIN
+
+// Usage: optimizer [--ssa] [file]. Without a file the built-in sample is
+// used. Prints the TAC before and after the passes, and what each one did;
+// --ssa also takes the result into SSA form and back, printing it between.
+int main(int argc, char* argv[]) {
+    bool viaSSA = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--ssa") viaSSA = true;
+        else path = argv[i];
+    }
+
+    SourceFile file;
+    if (path && !file.open(path)) return 1;
+    string_view source = path ? file.text() : string_view(SAMPLE_PROGRAM);
+
+    Diagnostics diagnostics;
+    TACProgram program;
+    if (!compileToTAC(source, program, diagnostics)) {
+        diagnostics.print(cerr);
+        return 1;
+    }
+
+    cout << "Generated TAC:" << endl;
+    program.print(cout);
+    size_t before = program.code.size();
+
+    ConstantPropagationStats constantStats = propagateConstants(program);
+    cout << "\nConstant propagation: " << constantStats.folded << " folded, " << constantStats.operands
+         << " operands replaced, " << constantStats.branches << " branches decided, " << constantStats.deadBlocks
+         << " dead blocks removed" << endl;
+
+    ValueNumberingStats valueStats = numberValues(program);
+    cout << "Value numbering: " << valueStats.redundant << " redundant expressions, " << valueStats.simplified
+         << " simplified, " << valueStats.loads
+         << " loads reused, " << valueStats.copies << " copies dropped" << endl;
+
+    DeadCodeStats deadStats = eliminateDeadCode(program);
+    cout << "Dead code: " << deadStats.dead << " dead, " << deadStats.deadStores << " dead stores, "
+         << deadStats.unreachable << " unreachable, " << deadStats.jumps << " jumps and labels" << endl;
+
+    if (viaSSA) {
+        SSAForm ssa(std::move(program));
+        cout << "\nSSA form:" << endl;
+        ssa.print(cout);
+        program = ssa.destruct();
+        const SSAStats& ssaStats = ssa.statistics();
+        cout << "\nSSA: " << ssaStats.phis << " phis, " << ssaStats.versions << " versions, " << ssaStats.copies
+             << " copies out, " << ssaStats.splitEdges << " edges split, " << ssaStats.cycles << " cycles broken"
+             << endl;
+    }
+
+    cout << "\nOptimized TAC (" << before << " -> " << program.code.size() << " instructions):" << endl;
+    program.print(cout);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#define BASIC_BLOCK_NO_MAIN
+#include "basic_block.cpp"
+
+// ---------------------------------------------------------------------------
+// Optimizer passes over a TACProgram. Each pass builds the CFG it needs,
+// rewrites program.code in place and reports what it changed; the tables
+// (variables, constants, temps, labels) only ever grow, so operands stay
+// valid from one pass to the next.
+// ---------------------------------------------------------------------------
+
+// Constants by value. The generator stores literals once per spelling, so
+// 2 and 02 are two constants holding the same number; passes that compare
+// constants go through canonical() first. New values get a new constant.
+class ConstantPool {
+    TACProgram& program;
+    unordered_map<uint64_t, uint32_t> intIndex;   // value -> constant
+    unordered_map<uint64_t, uint32_t> floatIndex; // bit pattern -> constant
+    vector<uint32_t> canonicalIndex;
+
+    static uint64_t bitsOf(double real) {
+        uint64_t bits;
+        memcpy(&bits, &real, sizeof bits);
+        return bits;
+    }
+
+    // Shortest text that reads back as the same double, always with a
+    // point or exponent so it still looks like a float
+    static string floatText(double real) {
+        char buffer[32];
+        for (int precision = 1; precision <= 17; precision++) {
+            snprintf(buffer, sizeof buffer, "%.*g", precision, real);
+            if (strtod(buffer, nullptr) == real) break;
+        }
+        string text(buffer);
+        if (text.find_first_of(".eni") == string::npos) text += ".0";
+        return text;
+    }
+
+    uint32_t add(const TACConstant& value) {
+        program.constants.push_back(value);
+        canonicalIndex.push_back((uint32_t)program.constants.size() - 1);
+        return (uint32_t)program.constants.size() - 1;
+    }
+
+public:
+    explicit ConstantPool(TACProgram& program) : program(program) {
+        for (uint32_t i = 0; i < program.constants.size(); i++) {
+            const TACConstant& value = program.constants[i];
+            unordered_map<uint64_t, uint32_t>& index = value.type == ValueType::FLOAT ? floatIndex : intIndex;
+            uint64_t key = value.type == ValueType::FLOAT ? bitsOf(value.real) : (uint64_t)value.integer;
+            canonicalIndex.push_back(index.emplace(key, i).first->second);
+        }
+    }
+
+    uint32_t canonical(uint32_t constant) const { return canonicalIndex[constant]; }
+    const TACConstant& operator[](uint32_t constant) const { return program.constants[constant]; }
+
+    uint32_t integer(int64_t number) {
+        auto found = intIndex.find((uint64_t)number);
+        if (found != intIndex.end()) return found->second;
+        uint32_t constant = add(TACConstant{ValueType::INT, intern(to_string(number)), number, (double)number});
+        intIndex[(uint64_t)number] = constant;
+        return constant;
+    }
+
+    uint32_t real(double number) {
+        auto found = floatIndex.find(bitsOf(number));
+        if (found != floatIndex.end()) return found->second;
+        uint32_t constant = add(TACConstant{ValueType::FLOAT, intern(floatText(number)), (int64_t)0, number});
+        floatIndex[bitsOf(number)] = constant;
+        return constant;
+    }
+};
+
+// Variables first, then temps: a dense index over every name
+inline uint32_t nameIndex(const TACProgram& program, TACOperand operand) {
+    return operand.is(TACOperand::TEMP) ? (uint32_t)program.variables.size() + operand.index() : operand.index();
+}
+
+// The variables and temps an instruction reads. A store writes a single
+// element, so it counts as neither reading nor writing the whole array.
+template <typename Visit>
+void forEachRead(const TACInstruction& in, Visit visit) {
+    if (in.a.is(TACOperand::VARIABLE) || in.a.is(TACOperand::TEMP)) visit(in.a);
+    if (in.b.is(TACOperand::VARIABLE) || in.b.is(TACOperand::TEMP)) visit(in.b);
+}
+
+// The variable or temp an instruction writes, none for stores and jumps
+inline TACOperand writtenBy(const TACInstruction& in) {
+    if (in.op == TACOp::STORE || in.op == TACOp::LABEL || in.isJump() || in.op == TACOp::RETURN) return TACOperand();
+    return in.result;
+}
+
+// Which variables and temps are live on entry to and exit from each block
+// (liveness.cpp). Only names read in some block before that block writes
+// them get a slot; a temp read only where it's written never crosses a
+// block boundary and needs no bits. The sets are rows of 64-bit words, one
+// row per block, so the dataflow works a word at a time.
+class Liveness {
+public:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    Liveness(const TACProgram& program, const ControlFlowGraph& cfg);
+
+    uint32_t nameIndex(TACOperand operand) const { return ::nameIndex(program, operand); }
+    size_t nameCount() const { return program.variables.size() + program.temps.size(); }
+
+    size_t slotCount() const { return names.size(); }
+    uint32_t slot(TACOperand operand) const; // NO_SLOT unless a variable or temp with bits
+    TACOperand name(uint32_t slot) const { return names[slot]; }
+
+    bool liveIn(BlockId b, uint32_t slot) const { return test(in, b, slot); }
+    bool liveOut(BlockId b, uint32_t slot) const { return test(out, b, slot); }
+
+    template <typename Visit>
+    void forEachLiveOut(BlockId b, Visit visit) const {
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t bits = out[b * words + w]; bits; bits &= bits - 1) {
+                visit(names[w * 64 + __builtin_ctzll(bits)]);
+            }
+        }
+    }
+
+private:
+    const TACProgram& program;
+    const ControlFlowGraph& cfg;
+    vector<TACOperand> names;     // slot -> variable or temp
+    vector<uint32_t> slotOfName;  // name index -> slot
+    size_t words;                 // per row
+    vector<uint64_t> in;
+    vector<uint64_t> out;
+
+    bool test(const vector<uint64_t>& sets, BlockId b, uint32_t slot) const {
+        return slot != NO_SLOT && (sets[b * words + slot / 64] >> (slot % 64) & 1);
+    }
+
+    void findGlobalNames();
+    void solve();
+};
+
+// Sparse conditional constant propagation (constant_propagation.cpp)
+struct ConstantPropagationStats {
+    size_t folded = 0;          // instructions replaced by a constant or deleted
+    size_t operands = 0;        // variable and temp operands replaced by constants
+    size_t branches = 0;        // conditional jumps decided at compile time
+    size_t deadBlocks = 0;      // blocks never executed, removed
+};
+
+ConstantPropagationStats propagateConstants(TACProgram& program);
+
+// Dominator-scoped value numbering (value_numbering.cpp)
+struct ValueNumberingStats {
+    size_t redundant = 0;       // expressions already held somewhere
+    size_t simplified = 0;      // x + 0, x - x and the like
+    size_t loads = 0;           // loads of a value already loaded or stored
+    size_t copies = 0;          // copies of a value the variable already had
+};
+
+ValueNumberingStats numberValues(TACProgram& program);
+
+// Dead and unreachable code removal (dead_code.cpp)
+struct DeadCodeStats {
+    size_t dead = 0;            // instructions whose result is never read
+    size_t deadStores = 0;      // array stores no load can see
+    size_t unreachable = 0;     // instructions in blocks the entry never reaches
+    size_t jumps = 0;           // jumps to the next instruction, labels nothing jumps to
+};
+
+DeadCodeStats eliminateDeadCode(TACProgram& program);
+
+// Static single assignment form (ssa.cpp). Every write of a scalar
+// variable, or of a temp written more than once, gets a new temp of its
+// own, and where two of them meet a phi at the top of the block picks one
+// by the edge taken. A read with no write before it reads the variable
+// itself, which nothing writes any more. Phis are kept beside the code,
+// by block, so the instruction stream and its CFG are the program's own
+// with operands renamed; the other passes don't know about phis and
+// shouldn't be run on it.
+struct Phi {
+    TACOperand result;
+    TACOperand name;            // the variable or temp it merges versions of
+    uint32_t firstArgument;     // arguments[firstArgument + k] comes from predecessor k
+};
+
+struct SSAStats {
+    size_t phis = 0;
+    size_t versions = 0;        // temps made for writes
+    size_t copies = 0;          // emitted coming out of SSA
+    size_t splitEdges = 0;      // edges that needed a block of their own for their copies
+    size_t cycles = 0;          // copy cycles broken with a temp
+};
+
+class SSAForm {
+public:
+    explicit SSAForm(TACProgram program);
+    SSAForm(const SSAForm&) = delete;
+    SSAForm& operator=(const SSAForm&) = delete;
+
+    const TACProgram& code() const { return program; }
+    const ControlFlowGraph& graph() const { return cfg; }
+    const Phi* phisBegin(BlockId b) const { return phis.data() + phiStart[b]; }
+    const Phi* phisEnd(BlockId b) const { return phis.data() + phiStart[b + 1]; }
+    TACOperand argument(const Phi& phi, size_t predecessor) const { return arguments[phi.firstArgument + predecessor]; }
+    const SSAStats& statistics() const { return stats; }
+
+    void print(std::ostream& out) const;
+
+    // Back to plain TAC: each phi becomes copies at the end of its
+    // predecessors, a parallel copy per edge done one copy at a time
+    TACProgram destruct();
+
+private:
+    bool addedEntry; // a jump to the first label put in front, so nothing jumps to the entry
+    TACProgram program;
+    ControlFlowGraph cfg;
+    vector<uint32_t> phiStart;  // per block, same layout as cfg.succ
+    vector<Phi> phis;
+    vector<TACOperand> arguments;
+    vector<uint32_t> predecessorIndex; // per cfg.succ entry: where the source is among the target's predecessors
+    SSAStats stats;
+
+    void placePhis(const vector<bool>& renamed);
+    void rename(const vector<bool>& renamed);
+    void sequentialize(vector<pair<TACOperand, TACOperand>>& copies, vector<TACInstruction>& code);
+};
+
+#endif
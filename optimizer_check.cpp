@@ -0,0 +1,629 @@
+#define OPTIMIZER_NO_MAIN
+#include "optimizer.cpp"
+#include <random>
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Differential check of the optimizer. Random programs that always stop
+// are compiled to TAC, run by a small TAC interpreter, then run again after
+// each combination of passes; the two runs must see the same values. What a
+// run "sees" is every variable and array element at each return: before
+// it, a branch compares each one with a variable nothing writes, so the
+// passes have to keep the value but can't fold the test, and the
+// interpreter records the value instead of branching.
+//
+// Along the way the dominator tree is checked against the definition (a
+// dominates b if b can't be reached without going through a), and SSA form
+// against its own: one write per temp, every read dominated by its write.
+//
+// Usage: optimizer_check [programs] [first seed]. Stops at the first
+// failure with the seed and the program; exits 1 if there was one.
+// ---------------------------------------------------------------------------
+
+// Programs over ints a b c, a char h, floats f g, an int[3][4] d and a
+// float[5] e. Loops count with k0..k9, which only their own loop writes and
+// which end it after at most four turns; array subscripts are literals or
+// p and q, which only ever get literals in range. Variables start at zero,
+// so a program can open with a loop whose counter isn't set first, which
+// makes the first instruction a loop header.
+class ProgramGenerator {
+    mt19937 random;
+    int counter;
+
+    double chance() { return uniform_real_distribution<double>(0.0, 1.0)(random); }
+    int between(int low, int high) { return uniform_int_distribution<int>(low, high)(random); }
+    template <typename T>
+    T oneOf(const vector<T>& options) { return options[between(0, (int)options.size() - 1)]; }
+
+    string intVariable() { return oneOf<string>({"a", "b", "c", "h"}); }
+    string floatVariable() { return oneOf<string>({"f", "g"}); }
+    string element() { return "d[" + to_string(between(0, 2)) + "][" + to_string(between(0, 3)) + "]"; }
+
+    string intExpression(int depth) {
+        double r = chance();
+        if (depth > 3 || r < 0.25) {
+            return oneOf<string>({intVariable(), to_string(between(0, 9)), element(), "d[p][q]"});
+        }
+        if (r < 0.35) return "- " + intExpression(depth + 1);
+        if (r < 0.42) return "!" + intExpression(depth + 1);
+        if (r < 0.5) return "(" + intExpression(depth + 1) + ")";
+        if (r < 0.55) return "(" + intExpression(depth + 1) + " / " + to_string(between(1, 5)) + ")";
+        string op = oneOf<string>({"+", "-", "*", "+", "-", "<", "==", "!=", ">=", "&&", "||"});
+        return "(" + intExpression(depth + 1) + " " + op + " " + intExpression(depth + 1) + ")";
+    }
+
+    string floatExpression(int depth) {
+        double r = chance();
+        if (depth > 3 || r < 0.3) {
+            return oneOf<string>({floatVariable(), "1.5", "0.25", "e[" + to_string(between(0, 4)) + "]", "a"});
+        }
+        if (r < 0.4) return "- " + floatExpression(depth + 1);
+        string op = oneOf<string>({"+", "-", "*", "/"});
+        string right = chance() < 0.5 ? floatExpression(depth + 1) : intExpression(depth + 1);
+        return "(" + floatExpression(depth + 1) + " " + op + " " + right + ")";
+    }
+
+    string condition() {
+        if (chance() < 0.5) return intExpression(0);
+        string op = oneOf<string>({"<", ">", "<=", "==", "!="});
+        string right = chance() < 0.5 ? floatExpression(1) : intExpression(1);
+        return "(" + floatExpression(1) + " " + op + " " + right + ")";
+    }
+
+    string nextCounter() {
+        string k = "k" + to_string(counter);
+        counter = (counter + 1) % 10;
+        return k;
+    }
+
+    string statement(int depth, bool inLoop) {
+        double r = chance();
+        if (depth > 3 || r < 0.35) {
+            double t = chance();
+            if (t < 0.35) return intVariable() + " = " + intExpression(0) + ";";
+            if (t < 0.5) return floatVariable() + " = " + floatExpression(0) + ";";
+            if (t < 0.6) return element() + " = " + intExpression(0) + ";";
+            if (t < 0.65) return "{ p = " + to_string(between(0, 2)) + "; q = " + to_string(between(0, 3)) + "; }";
+            if (t < 0.7) return "d[p][q] = " + (chance() < 0.5 ? intExpression(0) : floatExpression(0)) + ";";
+            if (t < 0.78) {
+                return "e[" + to_string(between(0, 4)) + "] = " +
+                       (chance() < 0.5 ? floatExpression(0) : intExpression(0)) + ";";
+            }
+            if (t < 0.85) return intVariable() + " = " + condition() + ";";
+            if (t < 0.9 && inLoop) return "if (" + condition() + ") break;";
+            return intVariable() + " = " + floatVariable() + ";";
+        }
+        if (r < 0.55) {
+            string text = "if (" + condition() + ") " + statement(depth + 1, inLoop);
+            if (chance() < 0.5) text += " else " + statement(depth + 1, inLoop);
+            return text;
+        }
+        if (r < 0.7) {
+            string k = nextCounter();
+            string limit = to_string(between(1, 4));
+            string test = condition();
+            return "{ " + k + " = 0; while (" + k + " < " + limit + " && " + test + ") { " + k + " = " + k +
+                   " + 1; " + statement(depth + 1, true) + " } }";
+        }
+        if (r < 0.8) {
+            string k = nextCounter();
+            string body = statement(depth + 1, true);
+            string limit = to_string(between(1, 4));
+            return "{ " + k + " = 0; do { " + k + " = " + k + " + 1; " + body + " } while (" + k + " < " + limit +
+                   " && " + condition() + "); }";
+        }
+        string block = "{";
+        for (int n = between(1, 3); n > 0; n--) {
+            block += " " + statement(depth + 1, inLoop);
+        }
+        return block + " }";
+    }
+
+public:
+    explicit ProgramGenerator(uint32_t seed) : random(seed), counter(0) {}
+
+    string program() {
+        string text = "int main() { int a; int b; int c; float f; float g; int[3][4] d; float[5] e; int p; int q; "
+                      "char h;";
+        for (int k = 0; k < 10; k++) {
+            text += " int k" + to_string(k) + ";";
+        }
+        if (chance() < 0.2) {
+            string k = nextCounter();
+            string limit = to_string(between(1, 4));
+            string body = statement(1, true);
+            if (chance() < 0.5) {
+                text += " while (" + k + " < " + limit + " && " + condition() + ") { " + k + " = " + k + " + 1; " +
+                        body + " }";
+            } else {
+                text += " do { " + k + " = " + k + " + 1; " + body + " } while (" + k + " < " + limit + " && " +
+                        condition() + ");";
+            }
+        }
+        for (int n = between(1, 8); n > 0; n--) {
+            text += " " + statement(0, false);
+        }
+        return text + " return 0; }";
+    }
+};
+
+static uint32_t elementSize(ValueType type) {
+    return type == ValueType::FLOAT ? 8 : type == ValueType::CHAR ? 1 : 4;
+}
+
+// Put the observing branches before every return, and before the end in
+// case the code falls off it. They all go to one label past a return of
+// its own, so no branch is ever to the very next instruction.
+static TACOperand observe(TACProgram& program) {
+    uint32_t variableCount = (uint32_t)program.variables.size();
+    TACOperand zeroInt = TACOperand::variable(variableCount);
+    TACOperand zeroFloat = TACOperand::variable(variableCount + 1);
+    program.variables.push_back(TACVariable{intern("check.zero"), ValueType::INT, {}});
+    program.variables.push_back(TACVariable{intern("check.zero.f"), ValueType::FLOAT, {}});
+    TACOperand observed = TACOperand::label(program.labelCount++);
+
+    ConstantPool constants(program);
+    vector<TACInstruction> branches;
+    for (uint32_t v = 0; v < variableCount; v++) {
+        const TACVariable& variable = program.variables[v];
+        TACOperand zero = variable.type == ValueType::FLOAT ? zeroFloat : zeroInt;
+        if (variable.dimensions.empty()) {
+            branches.push_back(TACInstruction(TACOp::IF, variable.type, observed, TACOperand::variable(v), zero,
+                                              TACCondition::EQ));
+            continue;
+        }
+        int64_t elements = 1;
+        for (int64_t dimension : variable.dimensions) {
+            elements *= dimension;
+        }
+        for (int64_t k = 0; k < elements; k++) {
+            TACOperand element = TACOperand::temp((uint32_t)program.temps.size());
+            program.temps.push_back(variable.type);
+            TACOperand offset = TACOperand::constant(constants.integer(k * elementSize(variable.type)));
+            branches.push_back(TACInstruction(TACOp::LOAD, variable.type, element, TACOperand::variable(v), offset));
+            branches.push_back(TACInstruction(TACOp::IF, variable.type, observed, element, zero, TACCondition::EQ));
+        }
+    }
+
+    vector<TACInstruction> code;
+    for (const TACInstruction& in : program.code) {
+        if (in.op == TACOp::RETURN) code.insert(code.end(), branches.begin(), branches.end());
+        code.push_back(in);
+    }
+    code.insert(code.end(), branches.begin(), branches.end());
+    code.push_back(TACInstruction(TACOp::RETURN, ValueType::VOID, TACOperand()));
+    code.push_back(TACInstruction(TACOp::LABEL, ValueType::VOID, observed));
+    program.code = std::move(code);
+    return observed;
+}
+
+struct Value {
+    bool real;
+    int64_t integer;
+    double number;
+
+    static Value of(int64_t integer) { return Value{false, integer, 0.0}; }
+    static Value of(double number) { return Value{true, 0, number}; }
+
+    bool same(const Value& other) const {
+        if (real != other.real) return false;
+        if (!real) return integer == other.integer;
+        return memcmp(&number, &other.number, sizeof number) == 0 || (number != number && other.number != other.number);
+    }
+
+    string text() const { return real ? to_string(number) : to_string(integer); }
+};
+
+// Runs a TACProgram the way the generated code would: ints wrap, chars are
+// narrowed by TO_CHAR, arrays are addressed by byte offsets. Every name
+// starts out zero. A run that divides by zero or goes on too long is
+// STOPPED; one that reads a temp before writing it, mixes up int and float
+// or indexes outside an array is BROKEN, which correct passes never cause.
+class TACInterpreter {
+public:
+    enum Outcome { RUNNING, FINISHED, STOPPED, BROKEN };
+
+    TACInterpreter(const TACProgram& program, TACOperand observed) : program(program), observed(observed) {}
+
+    Outcome run() {
+        temps.assign(program.temps.size(), Value::of((int64_t)0));
+        written.assign(program.temps.size(), false);
+        for (const TACVariable& variable : program.variables) {
+            Value zero = variable.type == ValueType::FLOAT ? Value::of(0.0) : Value::of((int64_t)0);
+            variables.push_back(zero);
+            int64_t elements = variable.dimensions.empty() ? 0 : 1;
+            for (int64_t dimension : variable.dimensions) {
+                elements *= dimension;
+            }
+            arrays.push_back(vector<Value>(elements, zero));
+        }
+        vector<size_t> labels(program.labelCount, SIZE_MAX);
+        for (size_t i = 0; i < program.code.size(); i++) {
+            if (program.code[i].op == TACOp::LABEL) labels[program.code[i].result.index()] = i;
+        }
+
+        outcome = RUNNING;
+        size_t pc = 0;
+        for (long steps = 0; outcome == RUNNING; steps++) {
+            if (pc == program.code.size()) return outcome = FINISHED;
+            if (steps == STEP_LIMIT) stop(STOPPED, "too many steps");
+            const TACInstruction& in = program.code[pc++];
+            if (in.isJump() && labels[in.result.index()] == SIZE_MAX) stop(BROKEN, "jump to a missing label");
+            if (outcome == RUNNING) pc = execute(in, pc, labels);
+        }
+        return outcome;
+    }
+
+    const vector<Value>& trace() const { return seen; }
+    const string& problem() const { return why; }
+
+private:
+    static const long STEP_LIMIT = 10000000;
+
+    const TACProgram& program;
+    TACOperand observed;
+    vector<Value> temps;
+    vector<bool> written;
+    vector<Value> variables;
+    vector<vector<Value>> arrays;
+    vector<Value> seen;
+    Outcome outcome = RUNNING;
+    string why;
+
+    void stop(Outcome result, const string& reason) {
+        if (outcome != RUNNING) return;
+        outcome = result;
+        why = reason;
+    }
+
+    Value read(TACOperand operand, ValueType type) {
+        Value value = Value::of((int64_t)0);
+        switch (operand.kind()) {
+            case TACOperand::TEMP:
+                if (!written[operand.index()]) stop(BROKEN, "t" + to_string(operand.index() + 1) + " read before it's written");
+                value = temps[operand.index()];
+                break;
+            case TACOperand::VARIABLE:
+                value = variables[operand.index()];
+                break;
+            case TACOperand::CONSTANT: {
+                const TACConstant& constant = program.constants[operand.index()];
+                value = constant.type == ValueType::FLOAT ? Value::of(constant.real) : Value::of(constant.integer);
+                break;
+            }
+            default:
+                stop(BROKEN, "label read as a value");
+        }
+        if (value.real != (type == ValueType::FLOAT)) stop(BROKEN, "int and float mixed up");
+        return value;
+    }
+
+    void write(TACOperand operand, Value value) {
+        if (operand.is(TACOperand::TEMP)) {
+            temps[operand.index()] = value;
+            written[operand.index()] = true;
+        } else {
+            variables[operand.index()] = value;
+        }
+    }
+
+    Value* element(TACOperand array, Value offset, ValueType type) {
+        vector<Value>& elements = arrays[array.index()];
+        int64_t size = elementSize(type);
+        if (offset.integer < 0 || offset.integer % size || offset.integer / size >= (int64_t)elements.size()) {
+            stop(BROKEN, "array offset out of range");
+            return nullptr;
+        }
+        return &elements[offset.integer / size];
+    }
+
+    static bool compare(TACOp op, Value a, Value b) {
+        if (a.real) {
+            switch (op) {
+                case TACOp::EQ: return a.number == b.number;
+                case TACOp::NE: return a.number != b.number;
+                case TACOp::LT: return a.number < b.number;
+                case TACOp::LE: return a.number <= b.number;
+                case TACOp::GT: return a.number > b.number;
+                default: return a.number >= b.number;
+            }
+        }
+        switch (op) {
+            case TACOp::EQ: return a.integer == b.integer;
+            case TACOp::NE: return a.integer != b.integer;
+            case TACOp::LT: return a.integer < b.integer;
+            case TACOp::LE: return a.integer <= b.integer;
+            case TACOp::GT: return a.integer > b.integer;
+            default: return a.integer >= b.integer;
+        }
+    }
+
+    Value arithmetic(TACOp op, Value a, Value b) {
+        if (a.real) {
+            switch (op) {
+                case TACOp::ADD: return Value::of(a.number + b.number);
+                case TACOp::SUB: return Value::of(a.number - b.number);
+                case TACOp::MUL: return Value::of(a.number * b.number);
+                default: return Value::of(a.number / b.number);
+            }
+        }
+        uint64_t x = (uint64_t)a.integer, y = (uint64_t)b.integer;
+        switch (op) {
+            case TACOp::ADD: return Value::of((int64_t)(x + y));
+            case TACOp::SUB: return Value::of((int64_t)(x - y));
+            case TACOp::MUL: return Value::of((int64_t)(x * y));
+            default:
+                if (b.integer == 0 || (a.integer == INT64_MIN && b.integer == -1)) {
+                    stop(STOPPED, "division by zero");
+                    return a;
+                }
+                return Value::of(a.integer / b.integer);
+        }
+    }
+
+    Value toInteger(Value value) {
+        if (!value.real) return value;
+        if (!(value.number >= -9223372036854775808.0 && value.number < 9223372036854775808.0)) {
+            stop(STOPPED, "float out of int range");
+            return Value::of((int64_t)0);
+        }
+        return Value::of((int64_t)value.number);
+    }
+
+    // The instruction after this one
+    size_t execute(const TACInstruction& in, size_t next, const vector<size_t>& labels) {
+        switch (in.op) {
+            case TACOp::LABEL:
+                return next;
+            case TACOp::JUMP:
+                return labels[in.result.index()];
+            case TACOp::RETURN:
+                outcome = FINISHED;
+                return next;
+            case TACOp::IF:
+            case TACOp::IF_FALSE: {
+                Value a = read(in.a, in.type);
+                if (in.result == observed) {
+                    seen.push_back(a);
+                    return next;
+                }
+                bool taken;
+                if (in.condition == TACCondition::TRUTH) {
+                    taken = a.real ? a.number != 0.0 : a.integer != 0;
+                } else {
+                    TACOp op = static_cast<TACOp>(static_cast<int>(TACOp::EQ) + static_cast<int>(in.condition) - 1);
+                    taken = compare(op, a, read(in.b, in.type));
+                }
+                if (in.op == TACOp::IF_FALSE) taken = !taken;
+                return taken ? labels[in.result.index()] : next;
+            }
+            case TACOp::COPY:
+                write(in.result, read(in.a, in.type));
+                return next;
+            case TACOp::LOAD: {
+                Value* slot = element(in.a, read(in.b, ValueType::INT), in.type);
+                if (slot) write(in.result, *slot);
+                return next;
+            }
+            case TACOp::STORE: {
+                Value* slot = element(in.result, read(in.a, ValueType::INT), in.type);
+                Value value = read(in.b, in.type);
+                if (slot) *slot = value;
+                return next;
+            }
+            case TACOp::NEG: {
+                Value a = read(in.a, in.type);
+                write(in.result, a.real ? Value::of(-a.number) : Value::of((int64_t)(0 - (uint64_t)a.integer)));
+                return next;
+            }
+            case TACOp::NOT: {
+                Value a = read(in.a, in.type);
+                write(in.result, Value::of((int64_t)(a.real ? a.number == 0.0 : a.integer == 0)));
+                return next;
+            }
+            case TACOp::TO_FLOAT: {
+                Value a = read(in.a, in.type);
+                write(in.result, a.real ? a : Value::of((double)a.integer));
+                return next;
+            }
+            case TACOp::TO_INT:
+                write(in.result, toInteger(read(in.a, in.type)));
+                return next;
+            case TACOp::TO_CHAR:
+                write(in.result, Value::of((int64_t)(int8_t)toInteger(read(in.a, in.type)).integer));
+                return next;
+            default: {
+                Value a = read(in.a, in.type);
+                Value b = read(in.b, in.type);
+                if (in.op >= TACOp::EQ) {
+                    write(in.result, Value::of((int64_t)compare(in.op, a, b)));
+                } else {
+                    write(in.result, arithmetic(in.op, a, b));
+                }
+                return next;
+            }
+        }
+    }
+};
+
+// Empty if the tree matches the definition, else what's wrong
+static string checkDominators(const TACProgram& program) {
+    ControlFlowGraph cfg(program);
+    size_t count = cfg.size();
+    auto reach = [&](BlockId avoided) {
+        vector<bool> reached(count, false);
+        if (count == 0 || avoided == 0) return reached;
+        vector<BlockId> stack(1, 0);
+        reached[0] = true;
+        while (!stack.empty()) {
+            BlockId b = stack.back();
+            stack.pop_back();
+            for (BlockId s : cfg.successors(b)) {
+                if (s == avoided || reached[s]) continue;
+                reached[s] = true;
+                stack.push_back(s);
+            }
+        }
+        return reached;
+    };
+
+    vector<bool> reachable = reach(NO_BLOCK);
+    for (BlockId a = 0; a < count; a++) {
+        if (reachable[a] != cfg.reachable(a)) return "B" + to_string(a) + " reachable wrong";
+        vector<bool> without = reach(a);
+        for (BlockId b = 0; b < count; b++) {
+            bool dominates = reachable[a] && reachable[b] && (a == b || !without[b]);
+            if (dominates != cfg.dominates(a, b)) {
+                return "B" + to_string(a) + (dominates ? " dominates" : " doesn't dominate") + " B" + to_string(b);
+            }
+        }
+    }
+    // The immediate dominator is the strict dominator every other one dominates
+    for (BlockId b = 1; b < count; b++) {
+        if (!reachable[b]) continue;
+        BlockId i = cfg.idom[b];
+        if (i == b || !cfg.dominates(i, b)) return "idom of B" + to_string(b) + " doesn't dominate it";
+        for (BlockId c = 0; c < count; c++) {
+            if (c != b && cfg.dominates(c, b) && !cfg.dominates(c, i)) return "idom of B" + to_string(b) + " too high";
+        }
+    }
+    return "";
+}
+
+// Empty if every temp has one write and every read is dominated by it
+static string checkSSA(const SSAForm& ssa) {
+    const TACProgram& program = ssa.code();
+    const ControlFlowGraph& cfg = ssa.graph();
+    const uint32_t PHI = UINT32_MAX;
+    vector<BlockId> writeBlock(program.temps.size(), NO_BLOCK);
+    vector<uint32_t> writeAt(program.temps.size(), 0); // instruction, PHI for a phi
+    auto define = [&](TACOperand temp, BlockId b, uint32_t at) {
+        if (writeBlock[temp.index()] != NO_BLOCK) return false;
+        writeBlock[temp.index()] = b;
+        writeAt[temp.index()] = at;
+        return true;
+    };
+    for (BlockId b = 0; b < cfg.size(); b++) {
+        if (!cfg.reachable(b)) continue;
+        for (const Phi* phi = ssa.phisBegin(b); phi != ssa.phisEnd(b); phi++) {
+            if (!define(phi->result, b, PHI)) return program.operandText(phi->result) + " written twice";
+        }
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            TACOperand written = writtenBy(program.code[i]);
+            if (written.is(TACOperand::VARIABLE) && program.variables[written.index()].dimensions.empty()) {
+                return program.operandText(written) + " still written";
+            }
+            if (written.is(TACOperand::TEMP) && !define(written, b, i)) return program.operandText(written) + " written twice";
+        }
+    }
+
+    // A read at instruction at of block b; UINT32_MAX - 1 is the end of b
+    auto dominated = [&](TACOperand operand, BlockId b, uint32_t at) {
+        if (!operand.is(TACOperand::TEMP) || writeBlock[operand.index()] == NO_BLOCK) return true;
+        BlockId w = writeBlock[operand.index()];
+        if (w != b) return cfg.dominates(w, b);
+        return writeAt[operand.index()] == PHI || writeAt[operand.index()] < at;
+    };
+    for (BlockId b = 0; b < cfg.size(); b++) {
+        if (!cfg.reachable(b)) continue;
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            const TACInstruction& in = program.code[i];
+            if (!dominated(in.a, b, i) || !dominated(in.b, b, i)) return "read before its write at instruction " + to_string(i);
+        }
+        BlockList predecessors = cfg.predecessors(b);
+        for (const Phi* phi = ssa.phisBegin(b); phi != ssa.phisEnd(b); phi++) {
+            for (size_t k = 0; k < predecessors.size(); k++) {
+                if (!cfg.reachable(predecessors[k])) continue;
+                TACOperand argument = ssa.argument(*phi, k);
+                if (argument.none()) return program.operandText(phi->result) + " has no argument from B" + to_string(predecessors[k]);
+                if (!dominated(argument, predecessors[k], UINT32_MAX - 1)) {
+                    return program.operandText(phi->result) + " argument not written on the way from B" +
+                           to_string(predecessors[k]);
+                }
+            }
+        }
+    }
+    return "";
+}
+
+static void throughSSA(TACProgram& program) {
+    SSAForm ssa(std::move(program));
+    program = ssa.destruct();
+}
+
+static void allPasses(TACProgram& program) {
+    propagateConstants(program);
+    numberValues(program);
+    eliminateDeadCode(program);
+}
+
+struct Pipeline {
+    const char* name;
+    void (*run)(TACProgram& program);
+};
+
+static const Pipeline PIPELINES[] = {
+    {"constant propagation", [](TACProgram& p) { propagateConstants(p); }},
+    {"value numbering", [](TACProgram& p) { numberValues(p); }},
+    {"dead code", [](TACProgram& p) { eliminateDeadCode(p); }},
+    {"SSA round trip", throughSSA},
+    {"all passes", allPasses},
+    {"all passes twice, through SSA", [](TACProgram& p) { allPasses(p); throughSSA(p); allPasses(p); }},
+};
+
+static int failed(uint32_t seed, const string& what, const string& source) {
+    cout << "seed " << seed << ": " << what << endl << source << endl;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    int programs = argc > 1 ? atoi(argv[1]) : 200;
+    uint32_t firstSeed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1;
+
+    int stopped = 0;
+    for (int n = 0; n < programs; n++) {
+        uint32_t seed = firstSeed + n;
+        string source = ProgramGenerator(seed).program();
+        TACProgram program;
+        Diagnostics diagnostics;
+        if (!compileToTAC(source, program, diagnostics)) {
+            diagnostics.print(cout);
+            return failed(seed, "doesn't compile", source);
+        }
+
+        string problem = checkDominators(program);
+        if (!problem.empty()) return failed(seed, "dominators: " + problem, source);
+
+        TACOperand observed = observe(program);
+        TACInterpreter reference(program, observed);
+        TACInterpreter::Outcome outcome = reference.run();
+        if (outcome == TACInterpreter::BROKEN) return failed(seed, "unoptimized: " + reference.problem(), source);
+        if (outcome == TACInterpreter::STOPPED) {
+            stopped++;
+            continue;
+        }
+
+        for (const Pipeline& pipeline : PIPELINES) {
+            TACProgram optimized = program;
+            pipeline.run(optimized);
+            TACInterpreter run(optimized, observed);
+            string name = pipeline.name;
+            if (run.run() != TACInterpreter::FINISHED) return failed(seed, name + ": " + run.problem(), source);
+            if (run.trace().size() != reference.trace().size()) return failed(seed, name + ": not every value seen", source);
+            for (size_t k = 0; k < run.trace().size(); k++) {
+                if (!run.trace()[k].same(reference.trace()[k])) {
+                    return failed(seed, name + ": value " + to_string(k) + " is " + run.trace()[k].text() +
+                                            ", should be " + reference.trace()[k].text(), source);
+                }
+            }
+        }
+
+        SSAForm ssa(program);
+        problem = checkSSA(ssa);
+        if (!problem.empty()) return failed(seed, "SSA form: " + problem, source);
+    }
+
+    cout << programs << " programs (" << stopped << " stopped before the end), " << size(PIPELINES)
+         << " pass orders: all the same" << endl;
+    return 0;
+}
@@ -0,0 +1,393 @@
+#include "parser_phase_2.h"
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Direct AST mode: same grammar and same syntax errors as the CST parsers,
+// but every production goes straight to ASTBuilder and no CSTNode is made.
+// Statements run on an explicit stack of open statements and expressions
+// use operator precedence with explicit operand/operator stacks, so like
+// the iterative CST parser there is no recursion anywhere.
+// ---------------------------------------------------------------------------
+
+// Binding power of a binary operator token, 0 if it isn't one.
+// Levels 1-4 (|| && ==/!= relational) are non-associative: the grammar
+// takes one operator per level, so "a < b < c" ends the expression at the
+// second '<' exactly like parseRel does.
+static int binaryLevel(TokenType type) {
+    switch (type) {
+        case LOGIC_OR: return 1;
+        case LOGIC_AND: return 2;
+        case LOGIC_EQUAL: case LOGIC_NOT_EQUAL: return 3;
+        case LESS_THAN: case LESS_THAN_EQ: case GREATER_THAN: case GREATER_THAN_EQ: return 4;
+        case PLUS: case MINUS: return 5;
+        case MULTIPLY: case DIVIDE: return 6;
+        default: return 0;
+    }
+}
+
+ASTNode* Parser::parseAST(ASTBuilder& builder) {
+    panicking = false;
+
+    // Program -> basic main ( ) Block
+    if (!peek(BASIC)) {
+        error("Expected basic type (int, float, char, void)");
+        return nullptr;
+    }
+    tokens.advance();
+    if (!peek(MAIN)) {
+        error("Expected 'main'");
+        return nullptr;
+    }
+    tokens.advance();
+    expect(LEFT_PAREN);
+    expect(RIGHT_PAREN);
+
+    ASTNode* block = parseBlockAST(builder);
+    if (!tokens.atEnd()) {
+        error("Unexpected tokens after program end");
+    }
+    return builder.program(block);
+}
+
+// Decl -> basic ([ num ])* id ;
+ASTNode* Parser::parseDeclAST(ASTBuilder& builder) {
+    if (!match(BASIC)) {
+        error("Expected basic type");
+        return nullptr;
+    }
+    ASTNode* type = builder.type(intern(previousText()));
+    while (match(LEFT_BRACKET)) {
+        if (!match(INTEGER)) {
+            error("Expected number in array declaration");
+            delete type;
+            return nullptr;
+        }
+        builder.addDimension(type, intern(previousText()));
+        expect(RIGHT_BRACKET);
+    }
+    if (!match(IDENTIFIER)) {
+        error("Expected identifier");
+        delete type;
+        return nullptr;
+    }
+    ASTNode* decl = builder.declaration(intern(previousText()), type, tokens.previous().position);
+    expect(SEMICOLON);
+    return decl;
+}
+
+// Loc -> id ([ Bool ])*  (assignment targets; uses in expressions are
+// handled by parseExprAST itself)
+ASTNode* Parser::parseLocAST(ASTBuilder& builder) {
+    if (!match(IDENTIFIER)) {
+        error("Expected identifier");
+        return nullptr;
+    }
+    ASTNode* loc = builder.identifier(intern(previousText()), tokens.previous().position);
+    while (match(LEFT_BRACKET)) {
+        uint32_t bracket = tokens.previous().position;
+        ASTNode* subscript = parseExprAST(builder);
+        if (!subscript) {
+            delete loc;
+            return nullptr;
+        }
+        loc = builder.index(loc, subscript, bracket);
+        expect(RIGHT_BRACKET);
+    }
+    return loc;
+}
+
+// Bool, down through every level to Factor
+ASTNode* Parser::parseExprAST(ASTBuilder& builder) {
+    enum OpKind { BINARY_OP, UNARY_OP, PAREN_GROUP, INDEX_GROUP };
+    struct PendingOp {
+        OpKind kind;
+        TokenType op;
+        int level;
+        ASTNode* base;      // INDEX_GROUP: what is being indexed
+        uint32_t position;  // of the operator or '[' token
+    };
+    vector<ASTNode*> operands;
+    vector<PendingOp> ops;
+    bool wantOperand = true;
+
+    // Fold the top operator into its operands
+    auto reduce = [&]() {
+        PendingOp top = ops.back();
+        ops.pop_back();
+        ASTNode* right = operands.back();
+        operands.pop_back();
+        if (top.kind == UNARY_OP) {
+            operands.push_back(builder.unary(top.op, right, top.position));
+        } else {
+            ASTNode* left = operands.back();
+            operands.pop_back();
+            operands.push_back(builder.binary(top.op, left, right, top.position));
+        }
+    };
+    // Reduce down to the innermost open '(' or '[' (or everything)
+    auto reduceGroup = [&]() {
+        while (!ops.empty() && (ops.back().kind == BINARY_OP || ops.back().kind == UNARY_OP)) {
+            reduce();
+        }
+    };
+    // Close the innermost '(' or '[' group. Its closing token has been
+    // consumed, or was missing and reported: then it's taken as there,
+    // like expect() does in the CST parsers.
+    auto closeGroup = [&]() {
+        PendingOp group = ops.back();
+        ops.pop_back();
+        if (group.kind == INDEX_GROUP) {
+            ASTNode* indexed = builder.index(group.base, operands.back(), group.position);
+            operands.pop_back();
+            if (match(LEFT_BRACKET)) {
+                ops.push_back({INDEX_GROUP, INVALID, 0, indexed, tokens.previous().position});
+                wantOperand = true;
+                return;
+            }
+            operands.push_back(indexed);
+        }
+    };
+    // What the innermost open group expects to be closed with
+    auto missingCloser = [&]() {
+        error(ops.back().kind == PAREN_GROUP ? "Expected )" : "Expected ]");
+        closeGroup();
+    };
+
+    while (true) {
+        if (wantOperand) {
+            if (match(LOGIC_NOT) || match(MINUS)) {
+                ops.push_back({UNARY_OP, tokens.previous().type, 0, nullptr, tokens.previous().position});
+            }
+            else if (match(LEFT_PAREN)) {
+                ops.push_back({PAREN_GROUP, INVALID, 0, nullptr, 0});
+            }
+            else if (match(INTEGER)) {
+                operands.push_back(builder.integer(intern(previousText())));
+                wantOperand = false;
+            }
+            else if (match(REAL)) {
+                operands.push_back(builder.real(intern(previousText())));
+                wantOperand = false;
+            }
+            else if (match(IDENTIFIER)) {
+                ASTNode* name = builder.identifier(intern(previousText()), tokens.previous().position);
+                if (match(LEFT_BRACKET)) {
+                    ops.push_back({INDEX_GROUP, INVALID, 0, name, tokens.previous().position});
+                } else {
+                    operands.push_back(name);
+                    wantOperand = false;
+                }
+            }
+            else {
+                error("Invalid factor");
+                for (ASTNode* operand : operands) delete operand;
+                for (const PendingOp& op : ops) delete op.base;
+                return nullptr;
+            }
+            continue;
+        }
+
+        TokenType next = tokens.atEnd() ? INVALID : tokens.current().type;
+        int level = binaryLevel(next);
+        if (level > 0) {
+            // Unary operators and tighter (or equal, left-associative)
+            // binary operators finish first
+            while (!ops.empty() && ops.back().kind != PAREN_GROUP && ops.back().kind != INDEX_GROUP) {
+                const PendingOp& top = ops.back();
+                if (top.kind == UNARY_OP || top.level > level || (top.level == level && level >= 5)) {
+                    reduce();
+                } else {
+                    break;
+                }
+            }
+            bool repeated = !ops.empty() && ops.back().kind == BINARY_OP && ops.back().level == level;
+            if (!repeated) {
+                uint32_t at = tokens.current().position;
+                tokens.advance();
+                ops.push_back({BINARY_OP, next, level, nullptr, at});
+                wantOperand = true;
+                continue;
+            }
+            // Second non-associative operator: the expression ends here
+        }
+        else if (next == RIGHT_PAREN || next == RIGHT_BRACKET) {
+            reduceGroup();
+            if (!ops.empty()) {
+                if ((ops.back().kind == PAREN_GROUP) != (next == RIGHT_PAREN)) {
+                    missingCloser();
+                } else {
+                    tokens.advance();
+                    closeGroup();
+                }
+                continue;
+            }
+            // Not ours, it belongs to whoever called us
+        }
+
+        reduceGroup();
+        if (!ops.empty()) {
+            missingCloser();
+            continue;
+        }
+        return operands.back();
+    }
+}
+
+// Block -> { Decl* Stmt+ }, with every nested statement on an explicit stack
+ASTNode* Parser::parseBlockAST(ASTBuilder& builder) {
+    enum OpenKind { IN_BLOCK, IF_THEN, IF_ELSE, WHILE_BODY, DO_BODY };
+    struct OpenStmt {
+        OpenKind kind;
+        ASTNode* node;
+    };
+    vector<OpenStmt> stack;
+    ASTNode* done = nullptr; // finished statement waiting to be attached
+
+    // A statement failed to parse. The recursive parser loses every
+    // statement it was nested in up to the innermost block, so drop those,
+    // then skip ahead like parseNextStmt() does.
+    auto fail = [&]() {
+        while (stack.back().kind != IN_BLOCK) {
+            delete stack.back().node;
+            stack.pop_back();
+        }
+        synchronize();
+    };
+    // Opening brace and declarations of a block. Bad declarations are
+    // reported and left out, see parseNextDecl().
+    auto openBlock = [&]() {
+        expect(LEFT_BRACE);
+        ASTNode* block = builder.block();
+        stack.push_back({IN_BLOCK, block});
+        while (peek(BASIC)) {
+            ASTNode* decl = parseDeclAST(builder);
+            if (panicking) synchronize();
+            if (decl) builder.append(block, decl);
+        }
+        if (!peekStmtStart()) {
+            error("Invalid statements");
+        }
+    };
+
+    openBlock();
+
+    while (true) {
+        OpenStmt& top = stack.back();
+
+        // Attach a finished statement to whatever is waiting for it
+        if (done) {
+            ASTNode* stmt = done;
+            done = nullptr;
+            switch (top.kind) {
+                case IN_BLOCK:
+                    builder.append(top.node, stmt);
+                    if (panicking) synchronize();
+                    break;
+                case IF_THEN:
+                    builder.addBody(top.node, stmt);
+                    if (match(ELSE)) {
+                        top.kind = IF_ELSE;
+                    } else {
+                        done = top.node;
+                        stack.pop_back();
+                    }
+                    break;
+                case IF_ELSE:
+                case WHILE_BODY:
+                    builder.addBody(top.node, stmt);
+                    done = top.node;
+                    stack.pop_back();
+                    break;
+                case DO_BODY: {
+                    builder.addBody(top.node, stmt);
+                    expect(WHILE);
+                    expect(LEFT_PAREN);
+                    ASTNode* condition = parseExprAST(builder);
+                    if (!condition) {
+                        fail();
+                        break;
+                    }
+                    builder.addBody(top.node, condition);
+                    expect(RIGHT_PAREN);
+                    expect(SEMICOLON);
+                    done = top.node;
+                    stack.pop_back();
+                    break;
+                }
+            }
+            continue;
+        }
+
+        // End of a block
+        if (top.kind == IN_BLOCK && !peekStmtStart()) {
+            expect(RIGHT_BRACE);
+            done = top.node;
+            stack.pop_back();
+            if (stack.empty()) return done;
+            continue;
+        }
+
+        // Start the next statement, productions 7-13
+        if (match(IF)) {
+            expect(LEFT_PAREN);
+            ASTNode* condition = parseExprAST(builder);
+            if (!condition) {
+                fail();
+                continue;
+            }
+            expect(RIGHT_PAREN);
+            stack.push_back({IF_THEN, builder.ifStmt(condition)});
+        }
+        else if (peek(IDENTIFIER)) {
+            ASTNode* target = parseLocAST(builder);
+            if (!target) {
+                fail();
+                continue;
+            }
+            uint32_t at = peek(ASSIGNMENT) ? tokens.current().position : 0;
+            expect(ASSIGNMENT);
+            ASTNode* value = parseExprAST(builder);
+            if (!value) {
+                delete target;
+                fail();
+                continue;
+            }
+            expect(SEMICOLON);
+            done = builder.assign(target, value, at);
+        }
+        else if (match(WHILE)) {
+            expect(LEFT_PAREN);
+            ASTNode* condition = parseExprAST(builder);
+            if (!condition) {
+                fail();
+                continue;
+            }
+            expect(RIGHT_PAREN);
+            stack.push_back({WHILE_BODY, builder.whileStmt(condition)});
+        }
+        else if (match(DO)) {
+            stack.push_back({DO_BODY, builder.doWhile()});
+        }
+        else if (match(RETURN)) {
+            if (!match(INTEGER)) {
+                error("Expected number after return");
+                fail();
+                continue;
+            }
+            done = builder.returnStmt(builder.integer(intern(previousText())));
+            expect(SEMICOLON);
+        }
+        else if (match(BREAK)) {
+            uint32_t at = tokens.previous().position;
+            expect(SEMICOLON);
+            done = builder.breakStmt(at);
+        }
+        else if (peek(LEFT_BRACE)) {
+            openBlock();
+        }
+        else {
+            error("Invalid statement");
+            fail();
+        }
+    }
+}
@@ -0,0 +1,198 @@
+#include "parser_phase_2.h"
+#include <algorithm>
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Incremental re-parsing. Tokens never cross a newline (a comment ends with
+// its own), so re-lexing the lines an edit touches gives exactly the tokens
+// a full lex would; everything after just moves by the edit's byte and line
+// deltas. The CST stores no positions, only a token count per node, so the
+// tree is found by walking down from the root adding up counts.
+//
+// A Stmt or Block can be re-parsed on its own when the grammar reaches it
+// the same way as before: it still starts with a token that picks the same
+// production, and it ends on the same token after the edit, so the one token
+// of lookahead past it is unchanged. Anything else goes up a level, and
+// past the root becomes a full parse.
+//
+// Edits that leave the tokens as they were (whitespace, comments) never
+// parse, errors or not; the diagnostics just follow their tokens. Any
+// other edit to a file with syntax errors is a full parse: recovery adds
+// terminals that aren't tokens and skips tokens that end up in no node, so
+// token counts can't find a region in that tree.
+// ---------------------------------------------------------------------------
+
+IncrementalParser::IncrementalParser(SymbolTable& symTable, Diagnostics& diags)
+    : symbolTable(symTable), diagnostics(diags), root(nullptr), liveBytes(0), stats() {}
+
+void IncrementalParser::parseAll() {
+    arena.reset();
+    diagnostics.clear();
+    Parser parser(tokens, text, symbolTable, arena, diagnostics);
+    root = parser.parse();
+    if (root) root->countTokens();
+    liveBytes = arena.bytesAllocated();
+    stats.fullReparse = true;
+    stats.reparsedTokens = tokens.size();
+}
+
+CSTNode* IncrementalParser::open(string source) {
+    text = std::move(source);
+    tokens = lexer(text, symbolTable);
+    stats = IncrementalStats();
+    stats.relexedBytes = text.length();
+    parseAll();
+    return root;
+}
+
+CSTNode* IncrementalParser::edit(size_t offset, size_t removedLength, string_view inserted) {
+    if (offset > text.length()) offset = text.length();
+    if (removedLength > text.length() - offset) removedLength = text.length() - offset;
+    stats = IncrementalStats();
+
+    // Whole lines around the edit, in the old text
+    size_t lineBegin = offset == 0 ? string::npos : text.rfind('\n', offset - 1);
+    lineBegin = lineBegin == string::npos ? 0 : lineBegin + 1;
+    size_t oldLineEnd = text.find('\n', offset + removedLength);
+    oldLineEnd = oldLineEnd == string::npos ? text.length() : oldLineEnd + 1;
+
+    // Old tokens in that window, [first, removedEnd)
+    auto startsBefore = [](const Token& token, size_t at) { return token.offset < at; };
+    size_t first = lower_bound(tokens.begin(), tokens.end(), lineBegin, startsBefore) - tokens.begin();
+    size_t removedEnd = lower_bound(tokens.begin(), tokens.end(), oldLineEnd, startsBefore) - tokens.begin();
+
+    string oldWindow = text.substr(lineBegin, oldLineEnd - lineBegin);
+    text.replace(offset, removedLength, inserted.data(), inserted.length());
+    size_t newLineEnd = oldLineEnd - removedLength + inserted.length();
+    long byteDelta = (long)inserted.length() - (long)removedLength;
+
+    // Line the window starts on, counted from the last token before it
+    uint32_t line = 1;
+    size_t countFrom = 0;
+    if (first > 0) {
+        line = tokens[first - 1].line();
+        countFrom = tokens[first - 1].offset;
+    }
+    line += (uint32_t)count(text.begin() + countFrom, text.begin() + lineBegin, '\n');
+
+    // Re-lex the window, lines counted from 1 by the lexer
+    vector<Token> window;
+    Lexer lex(text, lineBegin, newLineEnd);
+    Token token;
+    while (lex.next(token)) {
+        token.position = Token::packPosition(token.line() + line - 1, token.column());
+        window.push_back(token);
+    }
+    insertIdentifiers(window, text, symbolTable);
+    stats.relexedBytes = newLineEnd - lineBegin;
+
+    long lineDelta = (long)count(text.begin() + lineBegin, text.begin() + newLineEnd, '\n') -
+                     (long)count(oldWindow.begin(), oldWindow.end(), '\n');
+    for (size_t i = removedEnd; (byteDelta || lineDelta) && i < tokens.size(); i++) {
+        tokens[i].offset = (uint32_t)(tokens[i].offset + byteDelta);
+        if (lineDelta) {
+            tokens[i].position = Token::packPosition((uint32_t)(tokens[i].line() + lineDelta), tokens[i].column());
+        }
+    }
+
+    // Same tokens as before (whitespace, a comment): the tree and the
+    // diagnostics stand as they are, at their tokens' new positions
+    bool sameTokens = window.size() == removedEnd - first;
+    for (size_t i = 0; sameTokens && i < window.size(); i++) {
+        const Token& before = tokens[first + i];
+        sameTokens = before.type == window[i].type &&
+                     string_view(oldWindow).substr(before.offset - lineBegin, before.length) == window[i].text(text);
+    }
+    if (sameTokens && diagnostics.hasErrors()) {
+        uint32_t windowLines = (uint32_t)count(oldWindow.begin(), oldWindow.end(), '\n');
+        diagnostics.movePositions([&](uint32_t& atLine, uint32_t& atColumn) {
+            if (atLine < line) return;
+            for (size_t i = 0; i < window.size(); i++) {
+                if (tokens[first + i].line() == atLine && tokens[first + i].column() == atColumn) {
+                    atLine = window[i].line();
+                    atColumn = window[i].column();
+                    return;
+                }
+            }
+            if (atLine >= line + windowLines) atLine = (uint32_t)(atLine + lineDelta);
+        });
+    }
+
+    if (window.size() == removedEnd - first) {
+        copy(window.begin(), window.end(), tokens.begin() + first);
+    } else {
+        tokens.erase(tokens.begin() + first, tokens.begin() + removedEnd);
+        tokens.insert(tokens.begin() + first, window.begin(), window.end());
+    }
+    if (sameTokens) return root;
+
+    // A tree with errors can't be split into regions (see above), and
+    // replaced subtrees pile up in the arena; both call for a fresh parse
+    bool clean = root && !diagnostics.hasErrors();
+    bool compact = arena.bytesAllocated() <= 2 * liveBytes;
+    if (!clean || !compact || !reparseRegion(first, removedEnd, window.size())) {
+        parseAll();
+    }
+    return root;
+}
+
+bool IncrementalParser::reparseRegion(size_t first, size_t removedEnd, size_t insertedCount) {
+    long tokenDelta = (long)insertedCount - (long)(removedEnd - first);
+
+    // Path from the root down to the smallest node holding the old tokens
+    // [first, removedEnd); start is each node's first token index
+    struct Step {
+        CSTNode* node;
+        CSTNode* parent;
+        size_t indexInParent;
+        size_t start;
+    };
+    vector<Step> path;
+    path.push_back({root, nullptr, 0, 0});
+    while (true) {
+        const Step& at = path.back();
+        CSTChildren children = at.node->getChildren();
+        size_t childStart = at.start;
+        bool found = false;
+        for (size_t i = 0; i < children.size() && childStart <= first; i++) {
+            size_t childEnd = childStart + children[i]->getTokenCount();
+            if (first < childEnd && removedEnd <= childEnd) {
+                path.push_back({children[i], at.node, i, childStart});
+                found = true;
+                break;
+            }
+            childStart = childEnd;
+        }
+        if (!found) break;
+    }
+
+    // Innermost Stmt/Block first
+    for (size_t k = path.size(); k-- > 1;) {
+        const Step& step = path[k];
+        NodeType type = step.node->getType();
+        if (type != NodeType::STMT && type != NodeType::BLOCK) continue;
+
+        size_t newEnd = step.start + step.node->getTokenCount() + tokenDelta;
+        if (newEnd <= step.start || newEnd > tokens.size()) continue;
+        TokenType lead = tokens[step.start].type;
+        bool sameProduction = type == NodeType::BLOCK
+            ? lead == LEFT_BRACE
+            : lead == IF || lead == IDENTIFIER || lead == WHILE || lead == DO ||
+              lead == BREAK || lead == RETURN || lead == LEFT_BRACE;
+        if (!sameProduction) continue;
+
+        Diagnostics regionErrors;
+        Parser parser(tokens, text, symbolTable, arena, regionErrors);
+        CSTNode* fresh = parser.parseAt(type, step.start);
+        if (!fresh || regionErrors.hasErrors() || parser.position() != newEnd) continue;
+
+        fresh->countTokens();
+        step.parent->setChild(step.indexInParent, fresh);
+        for (size_t up = 0; up < k; up++) {
+            path[up].node->adjustTokenCount(tokenDelta);
+        }
+        stats.reparsedTokens = newEnd - step.start;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,596 @@
+#include "parser_phase_2.h"
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Explicit-stack version of the recursive descent parser. Every parseX()
+// function becomes a few states: one to start it and one for each place it
+// resumes after a sub-production returns. A "call" pushes a frame and a
+// "return" pops it, leaving the node in `result` for the caller's next state.
+// The trees are node for node the same as the recursive parser's.
+//
+// Right-recursive lists (Stmts, Decls', Type', Loc') don't push a frame per
+// element: the frame appends each new list node to `tail` and loops, so the
+// stack only grows with real nesting (blocks, parentheses), and that growth
+// is heap memory instead of C++ stack.
+// ---------------------------------------------------------------------------
+
+Parser::ParseFrame::ParseFrame(ParseState state)
+    : state(state), node(nullptr), tail(nullptr) {}
+
+bool Parser::peekStmtStart() {
+    return peek(IF) || peek(IDENTIFIER) || peek(WHILE) || peek(DO) ||
+           peek(BREAK) || peek(RETURN) || peek(LEFT_BRACE);
+}
+
+CSTNode* Parser::parseIterative(ParseState start) {
+    vector<ParseFrame> stack;
+    stack.reserve(64);
+    stack.push_back(ParseFrame(start));
+    CSTNode* result = nullptr;
+
+    // Run production `entry`, then come back to this frame at state `next`
+    auto call = [&](ParseState next, ParseState entry) {
+        stack.back().state = next;
+        stack.push_back(ParseFrame(entry));
+    };
+    // Return `node` to the calling frame
+    auto finish = [&](CSTNode* node) {
+        result = node;
+        stack.pop_back();
+    };
+
+    while (!stack.empty()) {
+        // Not valid after call(), so every case breaks right after calling
+        ParseFrame& frame = stack.back();
+
+        switch (frame.state) {
+            // Program -> basic main ( ) Block
+            case ParseState::PROGRAM: {
+                frame.node = newNode(NodeType::PROGRAM);
+                if (!peek(BASIC)) {
+                    error("Expected basic type (int, float, char, void)");
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(newTerminal(BASIC, currentText()), arena);
+                tokens.advance();
+
+                if (!peek(MAIN)) {
+                    error("Expected 'main'");
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(newTerminal(MAIN, currentText()), arena);
+                tokens.advance();
+
+                expect(LEFT_PAREN);
+                frame.node->addChild(newTerminal(LEFT_PAREN, "("), arena);
+                expect(RIGHT_PAREN);
+                frame.node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
+                call(ParseState::PROGRAM_BLOCK, ParseState::BLOCK);
+                break;
+            }
+            case ParseState::PROGRAM_BLOCK:
+                if (!result) {
+                    error("Invalid block");
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                finish(frame.node);
+                break;
+
+            // Block -> { Decls? Stmts }
+            case ParseState::BLOCK:
+                frame.node = newNode(NodeType::BLOCK);
+                expect(LEFT_BRACE);
+                frame.node->addChild(newTerminal(LEFT_BRACE, "{"), arena);
+                if (peek(BASIC)) {
+                    call(ParseState::BLOCK_DECLS, ParseState::DECLS);
+                } else {
+                    result = nullptr;
+                    frame.state = ParseState::BLOCK_DECLS;
+                }
+                break;
+            case ParseState::BLOCK_DECLS:
+                // nullptr if every declaration was bad (and reported)
+                if (result) frame.node->addChild(result, arena);
+                if (!peekStmtStart()) {
+                    error("Invalid statements");
+                    result = nullptr;
+                    frame.state = ParseState::BLOCK_STMTS;
+                    break;
+                }
+                call(ParseState::BLOCK_STMTS, ParseState::STMTS);
+                break;
+            case ParseState::BLOCK_STMTS:
+                if (result) frame.node->addChild(result, arena);
+                expect(RIGHT_BRACE);
+                frame.node->addChild(newTerminal(RIGHT_BRACE, "}"), arena);
+                finish(frame.node);
+                break;
+
+            // Decls -> Decl Decls',  Decls' -> Decl Decls' | ε
+            // A Decl that fails is reported and left out (see parseNextDecl),
+            // the nodes are only made for ones that parse.
+            case ParseState::DECLS:
+                call(ParseState::DECLS_DECL, ParseState::DECL);
+                break;
+            case ParseState::DECLS_DECL: {
+                if (panicking) synchronize();
+                if (result) {
+                    // frame.tail is the Decls' node the Decl belongs to
+                    CSTNode* parent = frame.tail;
+                    if (!frame.node) {
+                        frame.node = newNode(NodeType::DECLS);
+                        parent = frame.node;
+                    }
+                    parent->addChild(result, arena);
+                    frame.tail = newNode(NodeType::DECLS_PRIME);
+                    parent->addChild(frame.tail, arena);
+                }
+                if (peek(BASIC)) {
+                    call(ParseState::DECLS_DECL, ParseState::DECL);
+                } else {
+                    if (frame.tail) frame.tail->addChild(CSTNode::createEpsilon(arena), arena);
+                    finish(frame.node);
+                }
+                break;
+            }
+
+            // Decl -> Type id ;
+            case ParseState::DECL:
+                frame.node = newNode(NodeType::DECL);
+                call(ParseState::DECL_TYPE, ParseState::TYPE);
+                break;
+            case ParseState::DECL_TYPE:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                if (!match(IDENTIFIER)) {
+                    error("Expected identifier");
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(newTerminal(IDENTIFIER, previousText()), arena);
+                expect(SEMICOLON);
+                frame.node->addChild(newTerminal(SEMICOLON, ";"), arena);
+                finish(frame.node);
+                break;
+
+            // Type -> basic Type',  Type' -> [ num ] Type' | ε
+            case ParseState::TYPE: {
+                frame.node = newNode(NodeType::TYPE);
+                if (!match(BASIC)) {
+                    error("Expected basic type");
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(newTerminal(BASIC, previousText()), arena);
+
+                CSTNode* tail = newNode(NodeType::TYPE_PRIME);
+                frame.node->addChild(tail, arena);
+                bool ok = true;
+                while (match(LEFT_BRACKET)) {
+                    tail->addChild(newTerminal(LEFT_BRACKET, "["), arena);
+                    if (!match(INTEGER)) {
+                        error("Expected number in array declaration");
+                        ok = false;
+                        break;
+                    }
+                    tail->addChild(newTerminal(INTEGER, previousText()), arena);
+                    expect(RIGHT_BRACKET);
+                    tail->addChild(newTerminal(RIGHT_BRACKET, "]"), arena);
+                    CSTNode* next = newNode(NodeType::TYPE_PRIME);
+                    tail->addChild(next, arena);
+                    tail = next;
+                }
+                if (!ok) {
+                    finish(nullptr);
+                    break;
+                }
+                tail->addChild(CSTNode::createEpsilon(arena), arena);
+                finish(frame.node);
+                break;
+            }
+
+            // Stmts -> Stmt Stmts?  (nullptr when no statement parses here)
+            // Bad statements are skipped like bad declarations are.
+            case ParseState::STMTS:
+                if (!peekStmtStart()) {
+                    finish(nullptr);
+                    break;
+                }
+                call(ParseState::STMTS_STMT, ParseState::STMT);
+                break;
+            case ParseState::STMTS_STMT:
+                if (panicking) synchronize();
+                if (result) {
+                    CSTNode* next = newNode(NodeType::STMTS);
+                    if (frame.tail) frame.tail->addChild(next, arena);
+                    else frame.node = next;
+                    frame.tail = next;
+                    frame.tail->addChild(result, arena);
+                }
+                if (peekStmtStart()) {
+                    call(ParseState::STMTS_STMT, ParseState::STMT);
+                } else {
+                    finish(frame.node);
+                }
+                break;
+
+            // Stmt, productions 7-13
+            case ParseState::STMT:
+                frame.node = newNode(NodeType::STMT);
+                if (match(IF)) {
+                    expect(LEFT_PAREN);
+                    frame.node->addChild(newTerminal(LEFT_PAREN, "("), arena);
+                    call(ParseState::STMT_IF_COND, ParseState::BOOL);
+                }
+                else if (peek(IDENTIFIER)) {
+                    call(ParseState::STMT_ASSIGN_LOC, ParseState::LOC);
+                }
+                else if (match(WHILE)) {
+                    expect(LEFT_PAREN);
+                    frame.node->addChild(newTerminal(LEFT_PAREN, "("), arena);
+                    call(ParseState::STMT_WHILE_COND, ParseState::BOOL);
+                }
+                else if (match(DO)) {
+                    call(ParseState::STMT_DO_BODY, ParseState::STMT);
+                }
+                else if (match(RETURN)) {
+                    frame.node->addChild(newTerminal(RETURN, "return"), arena);
+                    if (!match(INTEGER)) {
+                        error("Expected number after return");
+                        finish(nullptr);
+                        break;
+                    }
+                    frame.node->addChild(newTerminal(INTEGER, previousText()), arena);
+                    expect(SEMICOLON);
+                    frame.node->addChild(newTerminal(SEMICOLON, ";"), arena);
+                    finish(frame.node);
+                }
+                else if (match(BREAK)) {
+                    expect(SEMICOLON);
+                    frame.node->addChild(newTerminal(SEMICOLON, ";"), arena);
+                    finish(frame.node);
+                }
+                else if (peek(LEFT_BRACE)) {
+                    call(ParseState::STMT_DONE, ParseState::BLOCK);
+                }
+                else {
+                    error("Invalid statement");
+                    finish(nullptr);
+                }
+                break;
+            case ParseState::STMT_IF_COND:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(RIGHT_PAREN);
+                frame.node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
+                call(ParseState::STMT_IF_THEN, ParseState::STMT);
+                break;
+            case ParseState::STMT_IF_THEN:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                call(ParseState::STMT_DONE, ParseState::STMT_PRIME);
+                break;
+            case ParseState::STMT_ASSIGN_LOC:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(ASSIGNMENT);
+                frame.node->addChild(newTerminal(ASSIGNMENT, "="), arena);
+                call(ParseState::STMT_ASSIGN_VALUE, ParseState::BOOL);
+                break;
+            case ParseState::STMT_ASSIGN_VALUE:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(SEMICOLON);
+                frame.node->addChild(newTerminal(SEMICOLON, ";"), arena);
+                finish(frame.node);
+                break;
+            case ParseState::STMT_WHILE_COND:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(RIGHT_PAREN);
+                frame.node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
+                call(ParseState::STMT_DONE, ParseState::STMT);
+                break;
+            case ParseState::STMT_DO_BODY:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(WHILE);
+                frame.node->addChild(newTerminal(WHILE, "while"), arena);
+                expect(LEFT_PAREN);
+                frame.node->addChild(newTerminal(LEFT_PAREN, "("), arena);
+                call(ParseState::STMT_DO_COND, ParseState::BOOL);
+                break;
+            case ParseState::STMT_DO_COND:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(RIGHT_PAREN);
+                frame.node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
+                expect(SEMICOLON);
+                frame.node->addChild(newTerminal(SEMICOLON, ";"), arena);
+                finish(frame.node);
+                break;
+            case ParseState::STMT_DONE:
+                // Last child of an if/while/block statement
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                finish(frame.node);
+                break;
+
+            // Stmt' -> else Stmt | ε
+            case ParseState::STMT_PRIME:
+                frame.node = newNode(NodeType::STMT_PRIME);
+                if (match(ELSE)) {
+                    frame.node->addChild(newTerminal(ELSE, "else"), arena);
+                    call(ParseState::STMT_DONE, ParseState::STMT);
+                } else {
+                    frame.node->addChild(CSTNode::createEpsilon(arena), arena);
+                    finish(frame.node);
+                }
+                break;
+
+            // Loc -> id Loc',  Loc' -> [ Bool ] Loc' (no node when empty)
+            case ParseState::LOC:
+                frame.node = newNode(NodeType::LOC);
+                if (!match(IDENTIFIER)) {
+                    error("Expected identifier");
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(newTerminal(IDENTIFIER, previousText()), arena);
+                frame.tail = frame.node;
+                frame.state = ParseState::LOC_INDEX;
+                break;
+            case ParseState::LOC_INDEX: {
+                if (!match(LEFT_BRACKET)) {
+                    finish(frame.node);
+                    break;
+                }
+                CSTNode* next = newNode(NodeType::LOC_PRIME);
+                frame.tail->addChild(next, arena);
+                frame.tail = next;
+                next->addChild(newTerminal(LEFT_BRACKET, "["), arena);
+                call(ParseState::LOC_INDEX_DONE, ParseState::BOOL);
+                break;
+            }
+            case ParseState::LOC_INDEX_DONE:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.tail->addChild(result, arena);
+                expect(RIGHT_BRACKET);
+                frame.tail->addChild(newTerminal(RIGHT_BRACKET, "]"), arena);
+                frame.state = ParseState::LOC_INDEX;
+                break;
+
+            // Binary levels. Bool/Join/Equality/Rel take at most one operator
+            // and only make a node when there is one, like the recursive parser.
+            case ParseState::BOOL:
+                call(ParseState::BOOL_LEFT, ParseState::JOIN);
+                break;
+            case ParseState::BOOL_LEFT:
+                if (!result || !peek(LOGIC_OR)) {
+                    finish(result);
+                    break;
+                }
+                frame.node = newNode(NodeType::BOOL);
+                frame.node->addChild(result, arena);
+                match(LOGIC_OR);
+                frame.node->addChild(newTerminal(LOGIC_OR, "||"), arena);
+                call(ParseState::BINARY_RIGHT, ParseState::JOIN);
+                break;
+
+            case ParseState::JOIN:
+                call(ParseState::JOIN_LEFT, ParseState::EQUALITY);
+                break;
+            case ParseState::JOIN_LEFT:
+                if (!result || !peek(LOGIC_AND)) {
+                    finish(result);
+                    break;
+                }
+                frame.node = newNode(NodeType::JOIN);
+                frame.node->addChild(result, arena);
+                match(LOGIC_AND);
+                frame.node->addChild(newTerminal(LOGIC_AND, "&&"), arena);
+                call(ParseState::BINARY_RIGHT, ParseState::EQUALITY);
+                break;
+
+            case ParseState::EQUALITY:
+                call(ParseState::EQUALITY_LEFT, ParseState::REL);
+                break;
+            case ParseState::EQUALITY_LEFT: {
+                if (!result || !(peek(LOGIC_EQUAL) || peek(LOGIC_NOT_EQUAL))) {
+                    finish(result);
+                    break;
+                }
+                frame.node = newNode(NodeType::EQUALITY);
+                frame.node->addChild(result, arena);
+                TokenType op = tokens.current().type;
+                match(op);
+                frame.node->addChild(newTerminal(op, previousText()), arena);
+                call(ParseState::BINARY_RIGHT, ParseState::REL);
+                break;
+            }
+
+            case ParseState::REL:
+                call(ParseState::REL_LEFT, ParseState::EXPR);
+                break;
+            case ParseState::REL_LEFT: {
+                if (!result || !(peek(LESS_THAN) || peek(LESS_THAN_EQ) ||
+                                 peek(GREATER_THAN) || peek(GREATER_THAN_EQ))) {
+                    finish(result);
+                    break;
+                }
+                frame.node = newNode(NodeType::REL);
+                frame.node->addChild(result, arena);
+                TokenType op = tokens.current().type;
+                match(op);
+                frame.node->addChild(newTerminal(op, previousText()), arena);
+                call(ParseState::BINARY_RIGHT, ParseState::EXPR);
+                break;
+            }
+
+            case ParseState::BINARY_RIGHT:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                finish(frame.node);
+                break;
+
+            // Expr and Term loop over any number of operators
+            case ParseState::EXPR:
+                call(ParseState::EXPR_LEFT, ParseState::TERM);
+                break;
+            case ParseState::EXPR_LEFT:
+                if (!result || !(peek(PLUS) || peek(MINUS))) {
+                    finish(result);
+                    break;
+                }
+                frame.node = newNode(NodeType::EXPR);
+                frame.node->addChild(result, arena);
+                frame.state = ParseState::EXPR_OPERATOR;
+                break;
+            case ParseState::EXPR_OPERATOR: {
+                TokenType op = tokens.current().type;
+                match(op);
+                frame.node->addChild(newTerminal(op, previousText()), arena);
+                call(ParseState::EXPR_RIGHT, ParseState::TERM);
+                break;
+            }
+            case ParseState::EXPR_RIGHT:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                if (peek(PLUS) || peek(MINUS)) {
+                    frame.state = ParseState::EXPR_OPERATOR;
+                } else {
+                    finish(frame.node);
+                }
+                break;
+
+            case ParseState::TERM:
+                call(ParseState::TERM_LEFT, ParseState::UNARY);
+                break;
+            case ParseState::TERM_LEFT:
+                if (!result || !(peek(MULTIPLY) || peek(DIVIDE))) {
+                    finish(result);
+                    break;
+                }
+                frame.node = newNode(NodeType::TERM);
+                frame.node->addChild(result, arena);
+                frame.state = ParseState::TERM_OPERATOR;
+                break;
+            case ParseState::TERM_OPERATOR: {
+                TokenType op = tokens.current().type;
+                match(op);
+                frame.node->addChild(newTerminal(op, previousText()), arena);
+                call(ParseState::TERM_RIGHT, ParseState::UNARY);
+                break;
+            }
+            case ParseState::TERM_RIGHT:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                if (peek(MULTIPLY) || peek(DIVIDE)) {
+                    frame.state = ParseState::TERM_OPERATOR;
+                } else {
+                    finish(frame.node);
+                }
+                break;
+
+            // Unary -> ! Unary | - Unary | Factor
+            case ParseState::UNARY:
+                frame.node = newNode(NodeType::UNARY);
+                if (match(LOGIC_NOT)) {
+                    frame.node->addChild(newTerminal(LOGIC_NOT, "!"), arena);
+                    call(ParseState::UNARY_DONE, ParseState::UNARY);
+                }
+                else if (match(MINUS)) {
+                    frame.node->addChild(newTerminal(MINUS, "-"), arena);
+                    call(ParseState::UNARY_DONE, ParseState::UNARY);
+                }
+                else {
+                    call(ParseState::UNARY_DONE, ParseState::FACTOR);
+                }
+                break;
+            case ParseState::UNARY_DONE:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                finish(frame.node);
+                break;
+
+            // Factor -> ( Bool ) | num | real | Loc
+            case ParseState::FACTOR:
+                if (match(LEFT_PAREN)) {
+                    frame.node = newNode(NodeType::FACTOR);
+                    frame.node->addChild(newTerminal(LEFT_PAREN, "("), arena);
+                    call(ParseState::FACTOR_PAREN, ParseState::BOOL);
+                }
+                else if (match(INTEGER)) {
+                    finish(newTerminal(INTEGER, previousText()));
+                }
+                else if (match(REAL)) {
+                    finish(newTerminal(REAL, previousText()));
+                }
+                else if (peek(IDENTIFIER)) {
+                    frame.state = ParseState::LOC; // tail call, Loc's node is ours
+                }
+                else {
+                    error("Invalid factor");
+                    finish(nullptr);
+                }
+                break;
+            case ParseState::FACTOR_PAREN:
+                if (!result) {
+                    finish(nullptr);
+                    break;
+                }
+                frame.node->addChild(result, arena);
+                expect(RIGHT_PAREN);
+                frame.node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
+                finish(frame.node);
+                break;
+        }
+    }
+    return result;
+}
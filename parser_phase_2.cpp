@@ -1,4 +1,7 @@
 #include "parser_phase_2.h"
+#include "parser_iterative.cpp"
+#include "parser_ast.cpp"
+#include "parser_incremental.cpp"
 using namespace std;
 
 // NodeType to string conversion implementation
@@ -44,71 +47,232 @@ string nodeTypeToString(NodeType type) {
 
 // CSTNode implementation
 CSTNode::CSTNode(NodeType t)
-    : type(t), tokenType(INVALID) {}
+    : type(t), tokenType(INVALID), value(EMPTY_SYMBOL), children(nullptr),
+      childCount(0), childCapacity(0), tokenCount(0) {}
 
-CSTNode::CSTNode(TokenType tt, const string& val)
-    : type(NodeType::TERMINAL), value(val), tokenType(tt) {}
+CSTNode::CSTNode(TokenType tt, string_view val)
+    : type(NodeType::TERMINAL), tokenType(tt), value(intern(val)), children(nullptr),
+      childCount(0), childCapacity(0), tokenCount(1) {}
 
-CSTNode* CSTNode::createEpsilon() {
-    return new CSTNode(NodeType::EPSILON);
+CSTNode* CSTNode::createEpsilon(Arena& arena) {
+    return arena.make<CSTNode>(NodeType::EPSILON);
 }
 
-void CSTNode::addChild(CSTNode* child) {
-    if (child) children.push_back(child);
+void CSTNode::addChild(CSTNode* child, Arena& arena) {
+    if (!child) return;
+    if (childCount == childCapacity) {
+        // Most nodes have at most 4 children; the outgrown array is just
+        // left behind in the arena
+        uint32_t newCapacity = childCapacity ? childCapacity * 2 : 4;
+        CSTNode** grown = arena.makeArray<CSTNode*>(newCapacity);
+        if (childCount) memcpy(grown, children, childCount * sizeof(CSTNode*));
+        children = grown;
+        childCapacity = newCapacity;
+    }
+    children[childCount++] = child;
 }
 
-void CSTNode::printTree(int depth) const {
-    string indent(depth * 2, ' ');
-    cout << indent;
-    if (depth > 0) {
-        cout << "|-- ";
+void CSTNode::setChild(size_t index, CSTNode* child) {
+    if (index < childCount && child) children[index] = child;
+}
+
+void CSTNode::countTokens() {
+    // Preorder list walked backwards: children are always done before parents
+    vector<CSTNode*> order;
+    vector<CSTNode*> stack;
+    stack.push_back(this);
+    while (!stack.empty()) {
+        CSTNode* node = stack.back();
+        stack.pop_back();
+        order.push_back(node);
+        for (uint32_t i = 0; i < node->childCount; i++) stack.push_back(node->children[i]);
+    }
+    for (size_t i = order.size(); i-- > 0;) {
+        CSTNode* node = order[i];
+        if (node->type == NodeType::TERMINAL) continue;
+        node->tokenCount = 0;
+        for (uint32_t k = 0; k < node->childCount; k++) node->tokenCount += node->children[k]->tokenCount;
+
+        // if, while, do and break get no terminal of their own: a Stmt
+        // starting with '(', ';' or another Stmt has one more token
+        if (node->type == NodeType::STMT && node->childCount > 0) {
+            const CSTNode* first = node->children[0];
+            if (first->type == NodeType::STMT ||
+                (first->type == NodeType::TERMINAL && (first->tokenType == LEFT_PAREN || first->tokenType == SEMICOLON))) {
+                node->tokenCount++;
+            }
+        }
     }
+}
 
-    cout << "[" << (type == NodeType::TERMINAL ? value : nodeTypeToString(type)) << "]" << endl;
+void CSTNode::adjustTokenCount(long delta) {
+    tokenCount = (uint32_t)(tokenCount + delta);
+}
+
+void CSTNode::printTree(int depth) const {
+    // Explicit stack instead of recursion, the tree can be as deep as the input
+    vector<pair<const CSTNode*, int>> stack;
+    stack.push_back(make_pair(this, depth));
+    while (!stack.empty()) {
+        const CSTNode* node = stack.back().first;
+        int nodeDepth = stack.back().second;
+        stack.pop_back();
+
+        string indent(nodeDepth * 2, ' ');
+        cout << indent;
+        if (nodeDepth > 0) {
+            cout << "|-- ";
+        }
+
+        if (node->type == NodeType::TERMINAL) {
+            cout << "[" << symbolText(node->value) << "]" << endl;
+        } else {
+            cout << "[" << nodeTypeToString(node->type) << "]" << endl;
+        }
 
-    // Print children without epsilon nodes
-    for (const auto* child : children) {
-          child->printTree(depth + 1);
+        // Children go on in reverse so the first one prints next
+        for (uint32_t i = node->childCount; i-- > 0;) {
+            stack.push_back(make_pair(node->children[i], nodeDepth + 1));
+        }
     }
 }
 
 NodeType CSTNode::getType() const { return type; }
-string CSTNode::getValue() const { return value; }
+string_view CSTNode::getValue() const { return symbolText(value); }
+Symbol CSTNode::getSymbol() const { return value; }
 TokenType CSTNode::getTokenType() const { return tokenType; }
-const vector<CSTNode*>& CSTNode::getChildren() const { return children; }
+CSTChildren CSTNode::getChildren() const { return CSTChildren(children, childCount); }
+uint32_t CSTNode::getTokenCount() const { return tokenCount; }
+
+static_assert(std::is_trivially_destructible<CSTNode>::value, "CSTNode must be arena friendly");
+
+// Flat CST
+struct CSTFlatTraits {
+    NodeType kind(const CSTNode* node) const { return node->getType(); }
+    Symbol value(const CSTNode* node) const { return node->getSymbol(); }
+    TokenType token(const CSTNode* node) const { return node->getTokenType(); }
+    CSTChildren children(const CSTNode* node) const { return node->getChildren(); }
+};
+
+FlatTree<NodeType> flattenCST(const CSTNode* root) {
+    return flattenTree<NodeType>(root, CSTFlatTraits());
+}
+
+void printFlatCST(const FlatTree<NodeType>& tree) {
+    for (FlatIndex i = 0; i < tree.size(); i++) {
+        cout << string(tree.depth[i] * 2, ' ');
+        if (tree.depth[i] > 0) {
+            cout << "|-- ";
+        }
+        if (tree.kind[i] == NodeType::TERMINAL) {
+            cout << "[" << symbolText(tree.value[i]) << "]" << endl;
+        } else {
+            cout << "[" << nodeTypeToString(tree.kind[i]) << "]" << endl;
+        }
+    }
+}
+
+// TokenCursor implementation
+TokenCursor::TokenCursor(const vector<Token>& tokenStream)
+    : tokens(&tokenStream), lexer(nullptr), symbolTable(nullptr), batchPos(0),
+      index(0), hasCurrent(false) {
+    fill();
+}
+
+TokenCursor::TokenCursor(Lexer& lex, string_view source, SymbolTable& symTable)
+    : tokens(nullptr), lexer(&lex), source(source), symbolTable(&symTable), batchPos(0),
+      index(0), hasCurrent(false) {
+    batch.reserve(BATCH_SIZE);
+    fill();
+}
 
-CSTNode::~CSTNode() {
-    for (auto* child : children) {
-        delete child;
+void TokenCursor::fill() {
+    if (lexer) {
+        if (batchPos == batch.size()) {
+            // Pull the next batch and run the symbol table pass over it
+            batch.clear();
+            batchPos = 0;
+            Token token;
+            while (batch.size() < BATCH_SIZE && lexer->next(token)) {
+                batch.push_back(token);
+            }
+            insertIdentifiers(batch, source, *symbolTable);
+        }
+        hasCurrent = batchPos < batch.size();
+        if (hasCurrent) currentToken = batch[batchPos++];
+    } else {
+        hasCurrent = index < tokens->size();
+        if (hasCurrent) currentToken = (*tokens)[index];
     }
-    children.clear();
+}
+
+bool TokenCursor::atEnd() const { return !hasCurrent; }
+const Token& TokenCursor::current() const { return currentToken; }
+const Token& TokenCursor::previous() const { return previousToken; }
+size_t TokenCursor::position() const { return index; }
+
+void TokenCursor::seek(size_t to) {
+    if (!tokens) return;
+    index = to;
+    previousToken = to > 0 && to <= tokens->size() ? (*tokens)[to - 1] : Token();
+    fill();
+}
+
+void TokenCursor::advance() {
+    if (!hasCurrent) return;
+    previousToken = currentToken;
+    index++;
+    fill();
 }
 
 // Parser implementation
-Parser::Parser(const vector<pair<TokenType, string>>& tokenStream, SymbolTable& symTable)
-    : tokens(tokenStream), currentPos(0), symbolTable(symTable) {}
+Parser::Parser(const vector<Token>& tokenStream, string_view source, SymbolTable& symTable,
+               Arena& cstArena, Diagnostics& diags)
+    : tokens(tokenStream), source(source), symbolTable(symTable), arena(cstArena),
+      diagnostics(diags), panicking(false) {}
+
+Parser::Parser(Lexer& lexer, string_view source, SymbolTable& symTable, Arena& cstArena,
+               Diagnostics& diags)
+    : tokens(lexer, source, symTable), source(source), symbolTable(symTable), arena(cstArena),
+      diagnostics(diags), panicking(false) {}
+
+CSTNode* Parser::newNode(NodeType type) {
+    return arena.make<CSTNode>(type);
+}
+
+CSTNode* Parser::newTerminal(TokenType type, string_view value) {
+    return arena.make<CSTNode>(type, value);
+}
+
+string_view Parser::currentText() const {
+    return tokens.current().text(source);
+}
+
+string_view Parser::previousText() const {
+    return tokens.previous().text(source);
+}
 
 CSTNode* Parser::createTerminal() {
-    if (currentPos < tokens.size()) {
-        TokenType type = tokens[currentPos].first;
-        string value = tokens[currentPos].second;
-        currentPos++;
-        return new CSTNode(type, value);
+    if (!tokens.atEnd()) {
+        TokenType type = tokens.current().type;
+        string_view value = currentText();
+        tokens.advance();
+        return newTerminal(type, value);
     }
     return nullptr;
 }
 
 bool Parser::match(TokenType type) {
-    if (currentPos < tokens.size() && tokens[currentPos].first == type) {
-        currentPos++;
+    if (!tokens.atEnd() && tokens.current().type == type) {
+        tokens.advance();
         return true;
     }
     return false;
 }
 
 bool Parser::peek(TokenType type) {
-    if (currentPos < tokens.size()) {
-        return tokens[currentPos].first == type;
+    if (!tokens.atEnd()) {
+        return tokens.current().type == type;
     }
     return false;
 }
@@ -119,246 +283,292 @@ void Parser::expect(TokenType type) {
     }
 }
 
+// Record a syntax error and go into panic mode. Whatever else goes wrong
+// before the next synchronize() is fallout from this one and isn't reported.
 void Parser::error(const string& message) {
-    cout << "Syntax Error: " << message;
-    if (currentPos < tokens.size()) {
-        cout << " at token '" << tokens[currentPos].second << "'";
+    if (panicking) return;
+    panicking = true;
+    if (tokens.atEnd()) {
+        diagnostics.report(DiagnosticKind::SYNTAX, message);
+    } else {
+        diagnostics.report(DiagnosticKind::SYNTAX, message, currentText(),
+                           tokens.current().line(), tokens.current().column());
+    }
+}
+
+// Leave panic mode: skip to just past a ';', or up to a '}' or a keyword
+// that starts a declaration or statement, whichever comes first.
+// Identifiers don't count, they show up in the middle of expressions too.
+// A '{' is skipped along with everything up to its '}', and a ';' right
+// before an 'else' ends an if branch, not the statement that went wrong.
+void Parser::synchronize() {
+    int depth = 0; // braces opened while skipping
+    while (!tokens.atEnd()) {
+        if (depth == 0) {
+            if (peek(RIGHT_BRACE) || peek(BASIC) || peek(IF) || peek(WHILE) || peek(DO) ||
+                peek(BREAK) || peek(RETURN)) {
+                break;
+            }
+            if (match(SEMICOLON)) {
+                if (!peek(ELSE)) break;
+                continue;
+            }
+        }
+        if (peek(LEFT_BRACE)) depth++;
+        else if (peek(RIGHT_BRACE)) depth--;
+        tokens.advance();
+    }
+    panicking = false;
+}
+
+// Next element of a declaration/statement list, nullptr when the list is
+// over. One that fails to parse is left out and the list goes on after the
+// synchronization point, so the tree has the same shape as an error-free one.
+CSTNode* Parser::parseNextDecl() {
+    while (peek(BASIC)) {
+        CSTNode* declNode = parseDecl();
+        if (panicking) synchronize();
+        if (declNode) return declNode;
     }
-    cout << endl;
-    exit(1);
+    return nullptr;
+}
+
+CSTNode* Parser::parseNextStmt() {
+    while (peekStmtStart()) {
+        CSTNode* stmtNode = parseStmt();
+        if (panicking) synchronize();
+        if (stmtNode) return stmtNode;
+    }
+    return nullptr;
 }
 
 // Grammar production functions
 CSTNode* Parser::parseProgram() {
-    CSTNode* node = new CSTNode(NodeType::PROGRAM);
+    CSTNode* node = newNode(NodeType::PROGRAM);
 
     if (!peek(BASIC)) {
         error("Expected basic type (int, float, char, void)");
         return nullptr;
     }
 
-    CSTNode* typeNode = new CSTNode(BASIC, tokens[currentPos].second);
-    node->addChild(typeNode);
-    currentPos++;
+    CSTNode* typeNode = newTerminal(BASIC, currentText());
+    node->addChild(typeNode, arena);
+    tokens.advance();
 
     if (!peek(MAIN)) {
         error("Expected 'main'");
         return nullptr;
     }
 
-    CSTNode* mainNode = new CSTNode(MAIN, tokens[currentPos].second);
-    node->addChild(mainNode);
-    currentPos++;
+    CSTNode* mainNode = newTerminal(MAIN, currentText());
+    node->addChild(mainNode, arena);
+    tokens.advance();
 
     expect(LEFT_PAREN);
-    node->addChild(new CSTNode(LEFT_PAREN, "("));
+    node->addChild(newTerminal(LEFT_PAREN, "("), arena);
 
     expect(RIGHT_PAREN);
-    node->addChild(new CSTNode(RIGHT_PAREN, ")"));
+    node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
 
     CSTNode* blockNode = parseBlock();
     if (!blockNode) {
         error("Invalid block");
         return nullptr;
     }
-    node->addChild(blockNode);
+    node->addChild(blockNode, arena);
 
     return node;
 }
 
 
 CSTNode* Parser::parseBlock() {
-    CSTNode* node = new CSTNode(NodeType::BLOCK);
+    CSTNode* node = newNode(NodeType::BLOCK);
 
     expect(LEFT_BRACE);
-    node->addChild(new CSTNode(LEFT_BRACE, "{"));
+    node->addChild(newTerminal(LEFT_BRACE, "{"), arena);
 
-    // Parse declarations if they exist
+    // Parse declarations if they exist. Bad ones were reported already and
+    // are left out, so there may be no Decls node at all.
     if (peek(BASIC)) {
         CSTNode* declsNode = parseDecls();
-        if (!declsNode) {
-            error("Invalid declarations");
-            return nullptr;
+        if (declsNode) {
+            node->addChild(declsNode, arena);
         }
-        node->addChild(declsNode);
     }
 
     // Parse statements
-    CSTNode* stmtsNode = parseStmts();
-    if (!stmtsNode) {
+    if (!peekStmtStart()) {
         error("Invalid statements");
-        return nullptr;
+    } else {
+        CSTNode* stmtsNode = parseStmts();
+        if (stmtsNode) {
+            node->addChild(stmtsNode, arena);
+        }
     }
-    node->addChild(stmtsNode);
 
     expect(RIGHT_BRACE);
-    node->addChild(new CSTNode(RIGHT_BRACE, "}"));
+    node->addChild(newTerminal(RIGHT_BRACE, "}"), arena);
 
     return node;
 }
 
 CSTNode* Parser::parseDecls() {
-    CSTNode* node = new CSTNode(NodeType::DECLS);
-
-    CSTNode* declNode = parseDecl();
+    CSTNode* declNode = parseNextDecl();
     if (!declNode) return nullptr;
-    node->addChild(declNode);
+
+    CSTNode* node = newNode(NodeType::DECLS);
+    node->addChild(declNode, arena);
 
     CSTNode* declsPrimeNode = parseDeclsPrime();
     if (!declsPrimeNode) return nullptr;
-    node->addChild(declsPrimeNode);
+    node->addChild(declsPrimeNode, arena);
 
     return node;
 }
 
 CSTNode* Parser::parseDecl() {
-    CSTNode* node = new CSTNode(NodeType::DECL);
+    CSTNode* node = newNode(NodeType::DECL);
 
     CSTNode* typeNode = parseType();
     if (!typeNode) return nullptr;
-    node->addChild(typeNode);
+    node->addChild(typeNode, arena);
 
     if (!match(IDENTIFIER)) {
         error("Expected identifier");
         return nullptr;
     }
-    node->addChild(new CSTNode(IDENTIFIER, tokens[currentPos-1].second));
+    node->addChild(newTerminal(IDENTIFIER, previousText()), arena);
 
     expect(SEMICOLON);
-    node->addChild(new CSTNode(SEMICOLON, ";"));
+    node->addChild(newTerminal(SEMICOLON, ";"), arena);
 
     return node;
 }
 
 CSTNode* Parser::parseType() {
-    CSTNode* node = new CSTNode(NodeType::TYPE);
+    CSTNode* node = newNode(NodeType::TYPE);
 
     if (!match(BASIC)) {
         error("Expected basic type");
         return nullptr;
     }
-    node->addChild(new CSTNode(BASIC, tokens[currentPos-1].second));
+    node->addChild(newTerminal(BASIC, previousText()), arena);
 
     CSTNode* typePrimeNode = parseTypePrime();
     if (!typePrimeNode) return nullptr;
-    node->addChild(typePrimeNode);
+    node->addChild(typePrimeNode, arena);
 
     return node;
 }
 
 CSTNode* Parser::parseStmts() {
-    if (!(peek(IF) || peek(IDENTIFIER) || peek(WHILE) || peek(DO) ||
-          peek(BREAK) || peek(RETURN) || peek(LEFT_BRACE))) {
-        return nullptr;
-    }
-
-    CSTNode* node = new CSTNode(NodeType::STMTS);
-
-    CSTNode* stmtNode = parseStmt();
+    CSTNode* stmtNode = parseNextStmt();
     if (!stmtNode) return nullptr;
-    node->addChild(stmtNode);
+
+    CSTNode* node = newNode(NodeType::STMTS);
+    node->addChild(stmtNode, arena);
 
     // Recursively parse more statements if they exist
     CSTNode* moreStmts = parseStmts();
     if (moreStmts) {
-        node->addChild(moreStmts);
+        node->addChild(moreStmts, arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseStmt() {
-    CSTNode* node = new CSTNode(NodeType::STMT);
+    CSTNode* node = newNode(NodeType::STMT);
 
     if (match(IF)) {
         expect(LEFT_PAREN);
-        node->addChild(new CSTNode(LEFT_PAREN, "("));
+        node->addChild(newTerminal(LEFT_PAREN, "("), arena);
 
         CSTNode* boolNode = parseBool();
         if (!boolNode) return nullptr;
-        node->addChild(boolNode);
+        node->addChild(boolNode, arena);
 
         expect(RIGHT_PAREN);
-        node->addChild(new CSTNode(RIGHT_PAREN, ")"));
+        node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
 
         CSTNode* stmtNode = parseStmt();
         if (!stmtNode) return nullptr;
-        node->addChild(stmtNode);
+        node->addChild(stmtNode, arena);
 
         CSTNode* stmtPrimeNode = parseStmtPrime();
         if (!stmtPrimeNode) return nullptr;
-        node->addChild(stmtPrimeNode);
+        node->addChild(stmtPrimeNode, arena);
     }
     else if (peek(IDENTIFIER)) {
         CSTNode* locNode = parseLoc();
         if (!locNode) return nullptr;
-        node->addChild(locNode);
+        node->addChild(locNode, arena);
 
         expect(ASSIGNMENT);
-        node->addChild(new CSTNode(ASSIGNMENT, "="));
+        node->addChild(newTerminal(ASSIGNMENT, "="), arena);
 
         CSTNode* boolNode = parseBool();
         if (!boolNode) return nullptr;
-        node->addChild(boolNode);
+        node->addChild(boolNode, arena);
 
         expect(SEMICOLON);
-        node->addChild(new CSTNode(SEMICOLON, ";"));
+        node->addChild(newTerminal(SEMICOLON, ";"), arena);
     }
     else if (match(WHILE)) {
         expect(LEFT_PAREN);
-        node->addChild(new CSTNode(LEFT_PAREN, "("));
+        node->addChild(newTerminal(LEFT_PAREN, "("), arena);
 
         CSTNode* boolNode = parseBool();
         if (!boolNode) return nullptr;
-        node->addChild(boolNode);
+        node->addChild(boolNode, arena);
 
         expect(RIGHT_PAREN);
-        node->addChild(new CSTNode(RIGHT_PAREN, ")"));
+        node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
 
         CSTNode* stmtNode = parseStmt();
         if (!stmtNode) return nullptr;
-        node->addChild(stmtNode);
+        node->addChild(stmtNode, arena);
     }
     else if (match(DO)) {
         CSTNode* stmtNode = parseStmt();
         if (!stmtNode) return nullptr;
-        node->addChild(stmtNode);
+        node->addChild(stmtNode, arena);
 
         expect(WHILE);
-        node->addChild(new CSTNode(WHILE, "while"));
+        node->addChild(newTerminal(WHILE, "while"), arena);
 
         expect(LEFT_PAREN);
-        node->addChild(new CSTNode(LEFT_PAREN, "("));
+        node->addChild(newTerminal(LEFT_PAREN, "("), arena);
 
         CSTNode* boolNode = parseBool();
         if (!boolNode) return nullptr;
-        node->addChild(boolNode);
+        node->addChild(boolNode, arena);
 
         expect(RIGHT_PAREN);
-        node->addChild(new CSTNode(RIGHT_PAREN, ")"));
+        node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
 
         expect(SEMICOLON);
-        node->addChild(new CSTNode(SEMICOLON, ";"));
+        node->addChild(newTerminal(SEMICOLON, ";"), arena);
     }
     else if (match(RETURN)) {
-        node->addChild(new CSTNode(RETURN, "return"));
+        node->addChild(newTerminal(RETURN, "return"), arena);
         if (!match(INTEGER)) {
             error("Expected number after return");
             return nullptr;
         }
-        node->addChild(new CSTNode(INTEGER, tokens[currentPos-1].second));
+        node->addChild(newTerminal(INTEGER, previousText()), arena);
 
         expect(SEMICOLON);
-        node->addChild(new CSTNode(SEMICOLON, ";"));
+        node->addChild(newTerminal(SEMICOLON, ";"), arena);
     }
     else if (match(BREAK)) {
         expect(SEMICOLON);
-        node->addChild(new CSTNode(SEMICOLON, ";"));
+        node->addChild(newTerminal(SEMICOLON, ";"), arena);
     }
     else if (peek(LEFT_BRACE)) {
         CSTNode* blockNode = parseBlock();
         if (!blockNode) return nullptr;
-        node->addChild(blockNode);
+        node->addChild(blockNode, arena);
     }
     else {
         error("Invalid statement");
@@ -369,17 +579,19 @@ CSTNode* Parser::parseStmt() {
 }
 
 CSTNode* Parser::parseLoc() {
-    CSTNode* node = new CSTNode(NodeType::LOC);
+    CSTNode* node = newNode(NodeType::LOC);
 
     if (!match(IDENTIFIER)) {
         error("Expected identifier");
         return nullptr;
     }
-    node->addChild(new CSTNode(IDENTIFIER, tokens[currentPos-1].second));
+    node->addChild(newTerminal(IDENTIFIER, previousText()), arena);
 
-    CSTNode* locPrime = parseLocPrime();
-    if (locPrime) {
-        node->addChild(locPrime);
+    // No Loc' node without a '[', but a bad subscript fails the Loc
+    if (peek(LEFT_BRACKET)) {
+        CSTNode* locPrime = parseLocPrime();
+        if (!locPrime) return nullptr;
+        node->addChild(locPrime, arena);
     }
 
     return node;
@@ -391,18 +603,15 @@ CSTNode* Parser::parseBool() {
 
     // If there's a logical OR, create a Bool node
     if (peek(LOGIC_OR)) {
-        CSTNode* node = new CSTNode(NodeType::BOOL);
-        node->addChild(joinNode);
+        CSTNode* node = newNode(NodeType::BOOL);
+        node->addChild(joinNode, arena);
 
         match(LOGIC_OR);
-        node->addChild(new CSTNode(LOGIC_OR, "||"));
+        node->addChild(newTerminal(LOGIC_OR, "||"), arena);
 
         CSTNode* rightJoin = parseJoin();
-        if (!rightJoin) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(rightJoin);
+        if (!rightJoin) return nullptr;
+        node->addChild(rightJoin, arena);
         return node;
     }
 
@@ -415,18 +624,15 @@ CSTNode* Parser::parseJoin() {
 
     // If there's a logical AND, create a Join node
     if (peek(LOGIC_AND)) {
-        CSTNode* node = new CSTNode(NodeType::JOIN);
-        node->addChild(equalityNode);
+        CSTNode* node = newNode(NodeType::JOIN);
+        node->addChild(equalityNode, arena);
 
         match(LOGIC_AND);
-        node->addChild(new CSTNode(LOGIC_AND, "&&"));
+        node->addChild(newTerminal(LOGIC_AND, "&&"), arena);
 
         CSTNode* rightEquality = parseEquality();
-        if (!rightEquality) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(rightEquality);
+        if (!rightEquality) return nullptr;
+        node->addChild(rightEquality, arena);
         return node;
     }
 
@@ -439,19 +645,16 @@ CSTNode* Parser::parseEquality() {
 
     // If there's an equality operator, create an Equality node
     if (peek(LOGIC_EQUAL) || peek(LOGIC_NOT_EQUAL)) {
-        CSTNode* node = new CSTNode(NodeType::EQUALITY);
-        node->addChild(relNode);
+        CSTNode* node = newNode(NodeType::EQUALITY);
+        node->addChild(relNode, arena);
 
-        TokenType op = tokens[currentPos].first;
+        TokenType op = tokens.current().type;
         match(op);
-        node->addChild(new CSTNode(op, tokens[currentPos-1].second));
+        node->addChild(newTerminal(op, previousText()), arena);
 
         CSTNode* rightRel = parseRel();
-        if (!rightRel) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(rightRel);
+        if (!rightRel) return nullptr;
+        node->addChild(rightRel, arena);
         return node;
     }
 
@@ -465,19 +668,16 @@ CSTNode* Parser::parseRel() {
     // If there's a relational operator, create a Rel node
     if (peek(LESS_THAN) || peek(LESS_THAN_EQ) ||
         peek(GREATER_THAN) || peek(GREATER_THAN_EQ)) {
-        CSTNode* node = new CSTNode(NodeType::REL);
-        node->addChild(exprNode);
+        CSTNode* node = newNode(NodeType::REL);
+        node->addChild(exprNode, arena);
 
-        TokenType op = tokens[currentPos].first;
+        TokenType op = tokens.current().type;
         match(op);
-        node->addChild(new CSTNode(op, tokens[currentPos-1].second));
+        node->addChild(newTerminal(op, previousText()), arena);
 
         CSTNode* rightExpr = parseExpr();
-        if (!rightExpr) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(rightExpr);
+        if (!rightExpr) return nullptr;
+        node->addChild(rightExpr, arena);
         return node;
     }
 
@@ -495,20 +695,17 @@ CSTNode* Parser::parseExpr() {
     }
 
     // Create expression node only if we have operators
-    CSTNode* node = new CSTNode(NodeType::EXPR);
-    node->addChild(termNode);
+    CSTNode* node = newNode(NodeType::EXPR);
+    node->addChild(termNode, arena);
 
     while (peek(PLUS) || peek(MINUS)) {
-        TokenType op = tokens[currentPos].first;
+        TokenType op = tokens.current().type;
         match(op);
-        node->addChild(new CSTNode(op, tokens[currentPos-1].second));
+        node->addChild(newTerminal(op, previousText()), arena);
 
         CSTNode* nextTerm = parseTerm();
-        if (!nextTerm) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(nextTerm);
+        if (!nextTerm) return nullptr;
+        node->addChild(nextTerm, arena);
     }
 
     return node;
@@ -524,46 +721,43 @@ CSTNode* Parser::parseTerm() {
     }
 
     // Create term node only if we have operators
-    CSTNode* node = new CSTNode(NodeType::TERM);
-    node->addChild(unaryNode);
+    CSTNode* node = newNode(NodeType::TERM);
+    node->addChild(unaryNode, arena);
 
     while (peek(MULTIPLY) || peek(DIVIDE)) {
-        TokenType op = tokens[currentPos].first;
+        TokenType op = tokens.current().type;
         match(op);
-        node->addChild(new CSTNode(op, tokens[currentPos-1].second));
+        node->addChild(newTerminal(op, previousText()), arena);
 
         CSTNode* nextUnary = parseUnary();
-        if (!nextUnary) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(nextUnary);
+        if (!nextUnary) return nullptr;
+        node->addChild(nextUnary, arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseUnary() {
-    CSTNode* node = new CSTNode(NodeType::UNARY);
+    CSTNode* node = newNode(NodeType::UNARY);
 
     if (match(LOGIC_NOT)) {
-        node->addChild(new CSTNode(LOGIC_NOT, "!"));
+        node->addChild(newTerminal(LOGIC_NOT, "!"), arena);
 
         CSTNode* unaryNode = parseUnary();
         if (!unaryNode) return nullptr;
-        node->addChild(unaryNode);
+        node->addChild(unaryNode, arena);
     }
     else if (match(MINUS)) {
-        node->addChild(new CSTNode(MINUS, "-"));
+        node->addChild(newTerminal(MINUS, "-"), arena);
 
         CSTNode* unaryNode = parseUnary();
         if (!unaryNode) return nullptr;
-        node->addChild(unaryNode);
+        node->addChild(unaryNode, arena);
     }
     else {
         CSTNode* factorNode = parseFactor();
         if (!factorNode) return nullptr;
-        node->addChild(factorNode);
+        node->addChild(factorNode, arena);
     }
 
     return node;
@@ -571,25 +765,22 @@ CSTNode* Parser::parseUnary() {
 
 CSTNode* Parser::parseFactor() {
     if (match(LEFT_PAREN)) {
-        CSTNode* node = new CSTNode(NodeType::FACTOR);
-        node->addChild(new CSTNode(LEFT_PAREN, "("));
+        CSTNode* node = newNode(NodeType::FACTOR);
+        node->addChild(newTerminal(LEFT_PAREN, "("), arena);
 
         CSTNode* boolNode = parseBool();
-        if (!boolNode) {
-            delete node;
-            return nullptr;
-        }
-        node->addChild(boolNode);
+        if (!boolNode) return nullptr;
+        node->addChild(boolNode, arena);
 
         expect(RIGHT_PAREN);
-        node->addChild(new CSTNode(RIGHT_PAREN, ")"));
+        node->addChild(newTerminal(RIGHT_PAREN, ")"), arena);
         return node;
     }
     else if (match(INTEGER)) {
-        return new CSTNode(INTEGER, tokens[currentPos-1].second);
+        return newTerminal(INTEGER, previousText());
     }
     else if (match(REAL)) {
-        return new CSTNode(REAL, tokens[currentPos-1].second);
+        return newTerminal(REAL, previousText());
     }
     else if (peek(IDENTIFIER)) {
         return parseLoc();
@@ -600,217 +791,213 @@ CSTNode* Parser::parseFactor() {
 }
 
 CSTNode* Parser::parseBlockPrime() {
-    CSTNode* node = new CSTNode(NodeType::BLOCK_PRIME);
+    CSTNode* node = newNode(NodeType::BLOCK_PRIME);
 
     if (match(RIGHT_BRACE)) {
-        node->addChild(new CSTNode(RIGHT_BRACE, "}"));
+        node->addChild(newTerminal(RIGHT_BRACE, "}"), arena);
         return node;
     }
 
     CSTNode* stmtsNode = parseStmts();
     if (!stmtsNode) return nullptr;
-    node->addChild(stmtsNode);
+    node->addChild(stmtsNode, arena);
 
     expect(RIGHT_BRACE);
-    node->addChild(new CSTNode(RIGHT_BRACE, "}"));
+    node->addChild(newTerminal(RIGHT_BRACE, "}"), arena);
 
     return node;
 }
 
 CSTNode* Parser::parseBlockDoublePrime() {
-    CSTNode* node = new CSTNode(NodeType::BLOCK_DOUBLE_PRIME);
+    CSTNode* node = newNode(NodeType::BLOCK_DOUBLE_PRIME);
 
     if (peek(BASIC)) {
         CSTNode* declsNode = parseDecls();
         if (!declsNode) return nullptr;
-        node->addChild(declsNode);
+        node->addChild(declsNode, arena);
     }
 
     CSTNode* stmtsNode = parseStmts();
     if (!stmtsNode) return nullptr;
-    node->addChild(stmtsNode);
+    node->addChild(stmtsNode, arena);
 
     return node;
 }
 
 CSTNode* Parser::parseStmtsPrime() {
-    CSTNode* node = new CSTNode(NodeType::STMTS_PRIME);
-
-    if (peek(IF) || peek(IDENTIFIER) || peek(WHILE) || peek(DO) ||
-        peek(BREAK) || peek(RETURN) || peek(LEFT_BRACE)) {
+    CSTNode* node = newNode(NodeType::STMTS_PRIME);
 
-        CSTNode* stmtNode = parseStmt();
-        if (!stmtNode) return nullptr;
-        node->addChild(stmtNode);
+    CSTNode* stmtNode = parseNextStmt();
+    if (stmtNode) {
+        node->addChild(stmtNode, arena);
 
         CSTNode* stmtsPrimeNode = parseStmtsPrime();
         if (!stmtsPrimeNode) return nullptr;
-        node->addChild(stmtsPrimeNode);
+        node->addChild(stmtsPrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseStmtPrime() {
-    CSTNode* node = new CSTNode(NodeType::STMT_PRIME);
+    CSTNode* node = newNode(NodeType::STMT_PRIME);
 
     if (match(ELSE)) {
-        node->addChild(new CSTNode(ELSE, "else"));
+        node->addChild(newTerminal(ELSE, "else"), arena);
 
         CSTNode* stmtNode = parseStmt();
         if (!stmtNode) return nullptr;
-        node->addChild(stmtNode);
+        node->addChild(stmtNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseEqualityPrime() {
-    CSTNode* node = new CSTNode(NodeType::EQUALITY_PRIME);
+    CSTNode* node = newNode(NodeType::EQUALITY_PRIME);
 
     if (match(LOGIC_EQUAL)) {
-        node->addChild(new CSTNode(LOGIC_EQUAL, "=="));
+        node->addChild(newTerminal(LOGIC_EQUAL, "=="), arena);
 
         CSTNode* relNode = parseRel();
         if (!relNode) return nullptr;
-        node->addChild(relNode);
+        node->addChild(relNode, arena);
     }
     else if (match(LOGIC_NOT_EQUAL)) {
-        node->addChild(new CSTNode(LOGIC_NOT_EQUAL, "!="));
+        node->addChild(newTerminal(LOGIC_NOT_EQUAL, "!="), arena);
 
         CSTNode* relNode = parseRel();
         if (!relNode) return nullptr;
-        node->addChild(relNode);
+        node->addChild(relNode, arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseRelPrime() {
-    CSTNode* node = new CSTNode(NodeType::REL_PRIME);
+    CSTNode* node = newNode(NodeType::REL_PRIME);
 
     if (match(LESS_THAN)) {
-        node->addChild(new CSTNode(LESS_THAN, "<"));
+        node->addChild(newTerminal(LESS_THAN, "<"), arena);
 
         CSTNode* exprNode = parseExpr();
         if (!exprNode) return nullptr;
-        node->addChild(exprNode);
+        node->addChild(exprNode, arena);
     }
     else if (match(LESS_THAN_EQ)) {
-        node->addChild(new CSTNode(LESS_THAN_EQ, "<="));
+        node->addChild(newTerminal(LESS_THAN_EQ, "<="), arena);
 
         CSTNode* exprNode = parseExpr();
         if (!exprNode) return nullptr;
-        node->addChild(exprNode);
+        node->addChild(exprNode, arena);
     }
     else if (match(GREATER_THAN_EQ)) {
-        node->addChild(new CSTNode(GREATER_THAN_EQ, ">="));
+        node->addChild(newTerminal(GREATER_THAN_EQ, ">="), arena);
 
         CSTNode* exprNode = parseExpr();
         if (!exprNode) return nullptr;
-        node->addChild(exprNode);
+        node->addChild(exprNode, arena);
     }
     else if (match(GREATER_THAN)) {
-        node->addChild(new CSTNode(GREATER_THAN, ">"));
+        node->addChild(newTerminal(GREATER_THAN, ">"), arena);
 
         CSTNode* exprNode = parseExpr();
         if (!exprNode) return nullptr;
-        node->addChild(exprNode);
+        node->addChild(exprNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
     return node;
 }
 
 CSTNode* Parser::parseExprPrime() {
-    CSTNode* node = new CSTNode(NodeType::EXPR_PRIME);
+    CSTNode* node = newNode(NodeType::EXPR_PRIME);
 
     if (match(PLUS)) {
-        node->addChild(new CSTNode(PLUS, "+"));
+        node->addChild(newTerminal(PLUS, "+"), arena);
 
         CSTNode* termNode = parseTerm();
         if (!termNode) return nullptr;
-        node->addChild(termNode);
+        node->addChild(termNode, arena);
     }
     else if (match(MINUS)) {
-        node->addChild(new CSTNode(MINUS, "-"));
+        node->addChild(newTerminal(MINUS, "-"), arena);
 
         CSTNode* termNode = parseTerm();
         if (!termNode) return nullptr;
-        node->addChild(termNode);
+        node->addChild(termNode, arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseTermPrime() {
-    CSTNode* node = new CSTNode(NodeType::TERM_PRIME);
+    CSTNode* node = newNode(NodeType::TERM_PRIME);
 
     if (match(MULTIPLY)) {
-        node->addChild(new CSTNode(MULTIPLY, "*"));
+        node->addChild(newTerminal(MULTIPLY, "*"), arena);
 
         CSTNode* unaryNode = parseUnary();
         if (!unaryNode) return nullptr;
-        node->addChild(unaryNode);
+        node->addChild(unaryNode, arena);
     }
     else if (match(DIVIDE)) {
-        node->addChild(new CSTNode(DIVIDE, "/"));
+        node->addChild(newTerminal(DIVIDE, "/"), arena);
 
         CSTNode* unaryNode = parseUnary();
         if (!unaryNode) return nullptr;
-        node->addChild(unaryNode);
+        node->addChild(unaryNode, arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseDeclsPrime() {
-    CSTNode* node = new CSTNode(NodeType::DECLS_PRIME);
+    CSTNode* node = newNode(NodeType::DECLS_PRIME);
 
-    if (peek(BASIC)) {
-        CSTNode* declNode = parseDecl();
-        if (!declNode) return nullptr;
-        node->addChild(declNode);
+    CSTNode* declNode = parseNextDecl();
+    if (declNode) {
+        node->addChild(declNode, arena);
 
         CSTNode* declsPrimeNode = parseDeclsPrime();
         if (!declsPrimeNode) return nullptr;
-        node->addChild(declsPrimeNode);
+        node->addChild(declsPrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseTypePrime() {
-    CSTNode* node = new CSTNode(NodeType::TYPE_PRIME);
+    CSTNode* node = newNode(NodeType::TYPE_PRIME);
 
     if (match(LEFT_BRACKET)) {
-        node->addChild(new CSTNode(LEFT_BRACKET, "["));
+        node->addChild(newTerminal(LEFT_BRACKET, "["), arena);
 
         if (!match(INTEGER)) {
             error("Expected number in array declaration");
             return nullptr;
         }
-        node->addChild(new CSTNode(INTEGER, tokens[currentPos-1].second));
+        node->addChild(newTerminal(INTEGER, previousText()), arena);
 
         expect(RIGHT_BRACKET);
-        node->addChild(new CSTNode(RIGHT_BRACKET, "]"));
+        node->addChild(newTerminal(RIGHT_BRACKET, "]"), arena);
 
         CSTNode* typePrimeNode = parseTypePrime();
         if (!typePrimeNode) return nullptr;
-        node->addChild(typePrimeNode);
+        node->addChild(typePrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
@@ -821,19 +1008,20 @@ CSTNode* Parser::parseLocPrime() {
         return nullptr;  // Don't create epsilon nodes for empty loc primes
     }
 
-    CSTNode* node = new CSTNode(NodeType::LOC_PRIME);
-    node->addChild(new CSTNode(LEFT_BRACKET, "["));
+    CSTNode* node = newNode(NodeType::LOC_PRIME);
+    node->addChild(newTerminal(LEFT_BRACKET, "["), arena);
 
     CSTNode* boolNode = parseBool();
     if (!boolNode) return nullptr;
-    node->addChild(boolNode);
+    node->addChild(boolNode, arena);
 
     expect(RIGHT_BRACKET);
-    node->addChild(new CSTNode(RIGHT_BRACKET, "]"));
+    node->addChild(newTerminal(RIGHT_BRACKET, "]"), arena);
 
-    CSTNode* nextPrime = parseLocPrime();
-    if (nextPrime) {
-        node->addChild(nextPrime);
+    if (peek(LEFT_BRACKET)) {
+        CSTNode* nextPrime = parseLocPrime();
+        if (!nextPrime) return nullptr;
+        node->addChild(nextPrime, arena);
     }
 
     return node;
@@ -841,99 +1029,99 @@ CSTNode* Parser::parseLocPrime() {
 
 
 CSTNode* Parser::parseBoolPrime() {
-    CSTNode* node = new CSTNode(NodeType::BOOL_PRIME);
+    CSTNode* node = newNode(NodeType::BOOL_PRIME);
 
     if (match(LOGIC_OR)) {
-        node->addChild(new CSTNode(LOGIC_OR, "||"));
+        node->addChild(newTerminal(LOGIC_OR, "||"), arena);
 
         CSTNode* joinNode = parseJoin();
         if (!joinNode) return nullptr;
-        node->addChild(joinNode);
+        node->addChild(joinNode, arena);
 
         CSTNode* boolPrimeNode = parseBoolPrime();
         if (!boolPrimeNode) return nullptr;
-        node->addChild(boolPrimeNode);
+        node->addChild(boolPrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseJoinPrime() {
-    CSTNode* node = new CSTNode(NodeType::JOIN_PRIME);
+    CSTNode* node = newNode(NodeType::JOIN_PRIME);
 
     if (match(LOGIC_AND)) {
-        node->addChild(new CSTNode(LOGIC_AND, "&&"));
+        node->addChild(newTerminal(LOGIC_AND, "&&"), arena);
 
         CSTNode* equalityNode = parseEquality();
         if (!equalityNode) return nullptr;
-        node->addChild(equalityNode);
+        node->addChild(equalityNode, arena);
 
         CSTNode* joinPrimeNode = parseJoinPrime();
         if (!joinPrimeNode) return nullptr;
-        node->addChild(joinPrimeNode);
+        node->addChild(joinPrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseEqualityDoublePrime() {
-    CSTNode* node = new CSTNode(NodeType::EQUALITY_DOUBLE_PRIME);
+    CSTNode* node = newNode(NodeType::EQUALITY_DOUBLE_PRIME);
 
     if (peek(LOGIC_EQUAL) || peek(LOGIC_NOT_EQUAL)) {
         CSTNode* equalityPrimeNode = parseEqualityPrime();
         if (!equalityPrimeNode) return nullptr;
-        node->addChild(equalityPrimeNode);
+        node->addChild(equalityPrimeNode, arena);
 
         CSTNode* equalityDoublePrimeNode = parseEqualityDoublePrime();
         if (!equalityDoublePrimeNode) return nullptr;
-        node->addChild(equalityDoublePrimeNode);
+        node->addChild(equalityDoublePrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseExprDoublePrime() {
-    CSTNode* node = new CSTNode(NodeType::EXPR_DOUBLE_PRIME);
+    CSTNode* node = newNode(NodeType::EXPR_DOUBLE_PRIME);
 
     if (peek(PLUS) || peek(MINUS)) {
         CSTNode* exprPrimeNode = parseExprPrime();
         if (!exprPrimeNode) return nullptr;
-        node->addChild(exprPrimeNode);
+        node->addChild(exprPrimeNode, arena);
 
         CSTNode* exprDoublePrimeNode = parseExprDoublePrime();
         if (!exprDoublePrimeNode) return nullptr;
-        node->addChild(exprDoublePrimeNode);
+        node->addChild(exprDoublePrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
 }
 
 CSTNode* Parser::parseTermDoublePrime() {
-    CSTNode* node = new CSTNode(NodeType::TERM_DOUBLE_PRIME);
+    CSTNode* node = newNode(NodeType::TERM_DOUBLE_PRIME);
 
     if (peek(MULTIPLY) || peek(DIVIDE)) {
         CSTNode* termPrimeNode = parseTermPrime();
         if (!termPrimeNode) return nullptr;
-        node->addChild(termPrimeNode);
+        node->addChild(termPrimeNode, arena);
 
         CSTNode* termDoublePrimeNode = parseTermDoublePrime();
         if (!termDoublePrimeNode) return nullptr;
-        node->addChild(termDoublePrimeNode);
+        node->addChild(termDoublePrimeNode, arena);
     }
     else {
-        node->addChild(CSTNode::createEpsilon());
+        node->addChild(CSTNode::createEpsilon(arena), arena);
     }
 
     return node;
@@ -989,11 +1177,25 @@ string Parser::tokenTypeToString(TokenType type) {
 }
 
 // Public parse method
-CSTNode* Parser::parse() {
-    CSTNode* root = parseProgram();
-    if (currentPos < tokens.size()) {
+CSTNode* Parser::parseAt(NodeType production, size_t firstToken) {
+    if (production != NodeType::STMT && production != NodeType::BLOCK) return nullptr;
+    tokens.seek(firstToken);
+    panicking = false;
+    return parseIterative(production == NodeType::BLOCK ? ParseState::BLOCK : ParseState::STMT);
+}
+
+size_t Parser::position() const {
+    return tokens.position();
+}
+
+// Returns nullptr only when not even the program header parsed; otherwise
+// the tree as far as it could be recovered (check the diagnostics)
+CSTNode* Parser::parse(ParseMode mode) {
+    panicking = false;
+    CSTNode* root = mode == ParseMode::RECURSIVE ? parseProgram()
+                                                 : parseIterative(ParseState::PROGRAM);
+    if (!tokens.atEnd()) {
         error("Unexpected tokens after program end");
-        return nullptr;
     }
     return root;
 }
@@ -4,10 +4,15 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <string_view>
 #include "lexer_phase_1.cpp"
+#include "arena.h"
+#include "flat_tree.h"
+#include "ast.h"
+#include "diagnostics.h"
 
 // Node types based on our grammar
-enum class NodeType {
+enum class NodeType : uint8_t {
     PROGRAM, BLOCK, BLOCK_PRIME, BLOCK_DOUBLE_PRIME, DECLS,
     DECLS_PRIME, DECL, TYPE, TYPE_PRIME, STMTS, STMTS_PRIME,
     STMT, STMT_PRIME, LOC, LOC_PRIME, BOOL, BOOL_PRIME, JOIN, JOIN_PRIME,
@@ -19,46 +24,162 @@ enum class NodeType {
 // Forward declaration of functions
 std::string nodeTypeToString(NodeType type);
 
+class CSTNode;
+
+// Read-only view of a node's children, which live in the parse arena
+class CSTChildren {
+private:
+    CSTNode* const* first;
+    size_t count;
+
+public:
+    CSTChildren(CSTNode* const* first, size_t count) : first(first), count(count) {}
+
+    CSTNode* const* begin() const { return first; }
+    CSTNode* const* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    CSTNode* operator[](size_t i) const { return first[i]; }
+};
+
+// CST nodes are carved out of an Arena owned by whoever called the parser,
+// and so is each node's child array. Nothing is freed per node: the whole
+// tree goes away with Arena::reset() (or when the arena is destroyed).
 class CSTNode {
 private:
     NodeType type;                    // Type of node
-    std::string value;                // Value for terminals (lexeme)
     TokenType tokenType;              // Token type for terminals
-    std::vector<CSTNode*> children;   // Child nodes
+    Symbol value;                     // Value for terminals (interned lexeme)
+    CSTNode** children;               // Child nodes, arena allocated
+    uint32_t childCount;
+    uint32_t childCapacity;
+    uint32_t tokenCount;              // Tokens under this node, see countTokens()
 
 public:
     // Constructors
     CSTNode(NodeType t);
-    CSTNode(TokenType tt, const std::string& val);
-    static CSTNode* createEpsilon();
+    CSTNode(TokenType tt, std::string_view val);
+    static CSTNode* createEpsilon(Arena& arena);
 
     // Tree operations
-    void addChild(CSTNode* child);
+    void addChild(CSTNode* child, Arena& arena);
+    void setChild(size_t index, CSTNode* child);
     void printTree(int depth = 0) const;
+    // Fill in tokenCount for the whole subtree. Only exact for trees parsed
+    // without errors, where every terminal is one token of the input.
+    void countTokens();
+    void adjustTokenCount(long delta);
 
     // Getters
     NodeType getType() const;
-    std::string getValue() const;
+    std::string_view getValue() const;
+    Symbol getSymbol() const;
     TokenType getTokenType() const;
-    const std::vector<CSTNode*>& getChildren() const;
+    CSTChildren getChildren() const;
+    uint32_t getTokenCount() const;
+};
+
+// Flat preorder copy of a CST, and a printer that matches CSTNode::printTree
+FlatTree<NodeType> flattenCST(const CSTNode* root);
+void printFlatCST(const FlatTree<NodeType>& tree);
+
+// Where the parser gets its tokens: either an already lexed vector (not
+// copied, it must outlive the parser) or a Lexer pulled in small batches.
+// Streaming mode interns each batch's identifiers into the symbol table, so
+// memory stays at one batch no matter how large the input is.
+class TokenCursor {
+private:
+    static const size_t BATCH_SIZE = 256;
+
+    const std::vector<Token>* tokens; // vector mode
+    Lexer* lexer;                     // streaming mode
+    std::string_view source;          // streaming mode
+    SymbolTable* symbolTable;         // streaming mode
+    std::vector<Token> batch;         // streaming mode lookahead
+    size_t batchPos;
+    size_t index;                     // number of tokens consumed
+    Token currentToken;
+    Token previousToken;
+    bool hasCurrent;
+
+    void fill();
+
+public:
+    explicit TokenCursor(const std::vector<Token>& tokenStream);
+    TokenCursor(Lexer& lexer, std::string_view source, SymbolTable& symTable);
+
+    bool atEnd() const;
+    const Token& current() const;
+    const Token& previous() const;
+    void advance();
+    size_t position() const;
+    // Continue from token `index` of the vector (vector mode only)
+    void seek(size_t index);
+};
 
-    // Destructor
-    ~CSTNode();
+// How Parser::parse() walks the grammar. Both build the same tree.
+enum class ParseMode {
+    RECURSIVE,  // recursive descent, one C++ call per grammar level (reference)
+    ITERATIVE   // explicit stack on the heap, no depth limit (default)
 };
 
 class Parser {
 private:
-    std::vector<std::pair<TokenType, std::string>> tokens;
-    size_t currentPos;
+    // States of the explicit-stack parser (parser_iterative.cpp). X is the
+    // start of production X, the rest are where X resumes after a call.
+    enum class ParseState : uint8_t {
+        PROGRAM, PROGRAM_BLOCK,
+        BLOCK, BLOCK_DECLS, BLOCK_STMTS,
+        DECLS, DECLS_DECL, DECL, DECL_TYPE, TYPE,
+        STMTS, STMTS_STMT,
+        STMT, STMT_IF_COND, STMT_IF_THEN, STMT_ASSIGN_LOC, STMT_ASSIGN_VALUE,
+        STMT_WHILE_COND, STMT_DO_BODY, STMT_DO_COND, STMT_DONE, STMT_PRIME,
+        LOC, LOC_INDEX, LOC_INDEX_DONE,
+        BOOL, BOOL_LEFT, JOIN, JOIN_LEFT, EQUALITY, EQUALITY_LEFT, REL, REL_LEFT,
+        BINARY_RIGHT,
+        EXPR, EXPR_LEFT, EXPR_OPERATOR, EXPR_RIGHT,
+        TERM, TERM_LEFT, TERM_OPERATOR, TERM_RIGHT,
+        UNARY, UNARY_DONE, FACTOR, FACTOR_PAREN
+    };
+
+    struct ParseFrame {
+        ParseState state;
+        CSTNode* node;   // node this production returns
+        CSTNode* tail;   // last node of a right-recursive list being built
+
+        explicit ParseFrame(ParseState state);
+    };
+
+    TokenCursor tokens;
+    std::string_view source;          // Buffer the tokens point into
     SymbolTable& symbolTable;
+    Arena& arena;                     // Where the CST is allocated
+    Diagnostics& diagnostics;         // Where syntax errors go
+    bool panicking;                   // Error seen, not yet synchronized
 
     // Helper functions
+    CSTNode* newNode(NodeType type);
+    CSTNode* newTerminal(TokenType type, std::string_view value);
     CSTNode* createTerminal();
+    std::string_view currentText() const;
+    std::string_view previousText() const;
     bool match(TokenType type);
     bool peek(TokenType type);
     void expect(TokenType type);
     void error(const std::string& message);
+    void synchronize();
     std::string tokenTypeToString(TokenType type);
+    bool peekStmtStart();
+    CSTNode* parseNextDecl();
+    CSTNode* parseNextStmt();
+
+    CSTNode* parseIterative(ParseState start);
+
+    // Direct AST construction (parser_ast.cpp)
+    ASTNode* parseBlockAST(ASTBuilder& builder);
+    ASTNode* parseDeclAST(ASTBuilder& builder);
+    ASTNode* parseLocAST(ASTBuilder& builder);
+    ASTNode* parseExprAST(ASTBuilder& builder);
 
     // Grammar production functions
     CSTNode* parseProgram(); // productions 1
@@ -97,8 +218,63 @@ private:
     CSTNode* parseTermDoublePrime(); // productions 82-83
 
 public:
-    Parser(const std::vector<std::pair<TokenType, std::string>>& tokenStream, SymbolTable& symTable);
-    CSTNode* parse();
+    // The returned tree lives in cstArena and is valid until it is reset.
+    // Syntax errors are added to diags and parsing goes on after them, so
+    // a tree may come back even when diags.hasErrors(); don't compile it.
+    Parser(const std::vector<Token>& tokenStream, std::string_view source, SymbolTable& symTable,
+           Arena& cstArena, Diagnostics& diags);
+    Parser(Lexer& lexer, std::string_view source, SymbolTable& symTable, Arena& cstArena,
+           Diagnostics& diags);
+    CSTNode* parse(ParseMode mode = ParseMode::ITERATIVE);
+    // Build the AST straight from the tokens, no CST is made
+    ASTNode* parseAST(ASTBuilder& builder);
+    // Parse a single Stmt or Block starting at token `firstToken` (vector
+    // mode only), for incremental re-parsing. position() is where it stopped.
+    CSTNode* parseAt(NodeType production, size_t firstToken);
+    size_t position() const;
+};
+
+// What the last IncrementalParser::edit() cost
+struct IncrementalStats {
+    size_t relexedBytes;    // size of the re-lexed line window
+    size_t reparsedTokens;  // tokens under the re-parsed subtree, 0 if none
+    bool fullReparse;       // the whole file had to be parsed again
+};
+
+// Keeps the tokens and CST of one file up to date across edits, for an
+// editor sending a change per keystroke. An edit re-lexes only the lines it
+// touches, then re-parses the smallest Stmt or Block around the changed
+// tokens and splices the new subtree in, so the cost follows the size of
+// the edit rather than the file. Falls back to a full parse when the file
+// has syntax errors or the region can't be re-parsed on its own.
+class IncrementalParser {
+private:
+    SymbolTable& symbolTable;
+    Diagnostics& diagnostics;   // always describes the current text
+    std::string text;
+    std::vector<Token> tokens;
+    Arena arena;                // current tree plus replaced subtrees
+    CSTNode* root;
+    size_t liveBytes;           // arena size right after the last full parse
+    IncrementalStats stats;
+
+    void parseAll();
+    bool reparseRegion(size_t first, size_t removedEnd, size_t insertedCount);
+
+public:
+    IncrementalParser(SymbolTable& symTable, Diagnostics& diags);
+    IncrementalParser(const IncrementalParser&) = delete;
+    IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+    // Start over with a whole new text
+    CSTNode* open(std::string source);
+    // Replace `removedLength` bytes at `offset` with `inserted`
+    CSTNode* edit(size_t offset, size_t removedLength, std::string_view inserted);
+
+    CSTNode* tree() const { return root; }
+    const std::string& source() const { return text; }
+    const std::vector<Token>& getTokens() const { return tokens; }
+    const IncrementalStats& lastEdit() const { return stats; }
 };
 
 #endif
@@ -1,233 +1,629 @@
-#include "parser_phase_2.cpp"
-#include <unordered_set>
-using namespace std;
-
-// AST Node for Abstract Syntax Tree
-class ASTNode {
-public:
-    string nodeType;
-    string value;
-    vector<ASTNode*> children;
-
-    // Constructors
-    ASTNode(const string& type) : nodeType(type) {}
-    ASTNode(const string& type, const string& val) : nodeType(type), value(val) {}
-
-    // Add a child node
-    void addChild(ASTNode* child) {
-        if (child != nullptr) {
-            children.push_back(child);
-        }
-    }
-
-    // Print the tree, kinda ugly but works
-    void printTree(int depth = 0) const {
-        string indent(depth * 2, ' ');
-        cout << indent << nodeType;
-        if (!value.empty()) {
-            cout << " (" << value << ")";
-        }
-        cout << endl;
-        for (auto* child : children) {
-            if (child != nullptr) {
-                child->printTree(depth + 1);
-            }
-        }
-    }
-
-    // Destructor to clean up
-    ~ASTNode() {
-        for (auto* child : children) {
-            delete child;
-        }
-    }
-};
-
-// Semantic analyzer that makes an AST and checks stuff
-class SemanticAnalyzer {
-private:
-    unordered_set<string> declaredVariables;
-
-    // Check if a variable was declared
-    void checkVariableDeclared(const string& varName) {
-        if (declaredVariables.find(varName) == declaredVariables.end()) {
-            cerr << "Error: Variable '" << varName << "' is not declared." << endl;
-            exit(1);
-        }
-    }
-
-    void errorchecking() {
-      cout << "Error here" << endl;
-    }
-
-    // Transform CST to AST
-    ASTNode* transformToAST(CSTNode* cstNode) {
-        if (!cstNode) return nullptr;
-
-        switch (cstNode->getType()) {
-            case NodeType::PROGRAM: {
-                ASTNode* programNode = new ASTNode("Program");
-                for (CSTNode* child : cstNode->getChildren()) {
-                    ASTNode* astChild = transformToAST(child);
-                    if (astChild) programNode->addChild(astChild);
-                }
-                return programNode;
-            }
-
-            case NodeType::BLOCK: {
-              ASTNode* blockNode = new ASTNode("Block");
-                for (CSTNode* child : cstNode->getChildren()) {
-                    ASTNode* astChild = transformToAST(child);
-                    if (astChild) blockNode->addChild(astChild);
-                }
-                return blockNode;
-            }
-
-            // Skip through DECLS
-            case NodeType::DECLS: {
-              ASTNode* firstChild = transformToAST(cstNode->getChildren()[0]);
-              return firstChild;
-            }
-            case NodeType::DECL: {
-                ASTNode* declNode = new ASTNode("Declaration");
-                for (CSTNode* child : cstNode->getChildren()) {
-                    ASTNode* astChild = transformToAST(child);
-                    if (astChild) declNode->addChild(astChild);
-                }
-                return declNode;
-            }
-
-            // Skip through TYPE
-            case NodeType::TYPE: {
-               ASTNode* firstChild = transformToAST(cstNode->getChildren()[0]);
-               return firstChild;
-
-            }
-            case NodeType::STMTS: {
-              ASTNode* stmtsNode = transformToAST(cstNode->getChildren()[0]);
-              stmtsNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              return stmtsNode;
-            }
-
-            case NodeType::STMT: {
-              CSTNode* firstChild = cstNode->getChildren()[0];
-              ASTNode* stmtNode = new ASTNode("Statement");
-                for (CSTNode* child : cstNode->getChildren()) {
-                    ASTNode* astChild = transformToAST(child);
-                    if (astChild) stmtNode->addChild(astChild);
-                }
-                  return stmtNode;
-            }
-
-            // Skip through these
-            case NodeType::LOC: {
-              ASTNode* locNode = transformToAST(cstNode->getChildren()[0]);
-              locNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              locNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return locNode;
-            }
-            case NodeType::BOOL: {
-              ASTNode* boolNode = transformToAST(cstNode->getChildren()[0]);
-              boolNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              boolNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return boolNode;
-            }
-            case NodeType::JOIN: {
-              ASTNode* joinNode = transformToAST(cstNode->getChildren()[0]);
-              joinNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              joinNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return joinNode;
-            }
-            case NodeType::EQUALITY: {
-              ASTNode* equalityNode = transformToAST(cstNode->getChildren()[0]);
-              equalityNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              equalityNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return equalityNode;
-            }
-            case NodeType::REL: {
-              ASTNode* relNode = transformToAST(cstNode->getChildren()[0]);
-              relNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              relNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return relNode;
-            }
-            case NodeType::EXPR: {
-              ASTNode* exprNode = transformToAST(cstNode->getChildren()[0]);
-              exprNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              exprNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return exprNode;
-            }
-            case NodeType::TERM: {
-              ASTNode* termNode = transformToAST(cstNode->getChildren()[0]);
-              termNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              termNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return termNode;
-            }
-            case NodeType::UNARY: {
-              ASTNode* unaryNode = transformToAST(cstNode->getChildren()[0]);
-              unaryNode->addChild(transformToAST(cstNode->getChildren()[1]));
-              unaryNode->addChild(transformToAST(cstNode->getChildren()[2]));
-              return unaryNode;
-            }
-            case NodeType::FACTOR: {
-               ASTNode* firstChild = transformToAST(cstNode->getChildren()[0]);
-               return firstChild;
-            }
-            default:
-                if (cstNode->getType() == NodeType::TERMINAL) {
-                    return new ASTNode("Terminal", cstNode->getValue());
-                }
-        }
-        return nullptr;
-    }
-
-public:
-    // This is the main function to analyze the CST
-    ASTNode* analyze(CSTNode* cstRoot) {
-        if (!cstRoot) {
-            cerr << "Error: Empty syntax tree." << endl;
-            exit(1);
-        }
-        return transformToAST(cstRoot);
-    }
-};
-
-// Test the semantic analyzer
-int main() {
-    SymbolTable symbolTable;
-
-    // Testing this mess
-    string code = R"(
-    int main() {
-    int a; int b; int c;
-    a = 3;
-    b = 5;
-    c = b - a;
-    b = a + c;
-    c = b - a;
-    return 0;
-    }
-    )";
-
-    // Lexical analysis
-    vector<pair<TokenType, string>> tokens = lexer(code, symbolTable);
-    cout << "Tokens:" << endl;
-    printTokens(tokens);
-
-    // Parsing
-    Parser parser(tokens, symbolTable);
-    CSTNode* syntaxTree = parser.parse();
-    cout << "\nConcrete Syntax Tree:" << endl;
-    syntaxTree->printTree();
-
-    // Semantic analysis
-    SemanticAnalyzer analyzer;
-    ASTNode* ast = analyzer.analyze(syntaxTree);
-    cout << "\nAbstract Syntax Tree:" << endl;
-    ast->printTree();
-
-    // Clean up time
-    delete syntaxTree;
-    delete ast;
-
-    return 0;
-}
+#include "parser_phase_2.cpp"
+using namespace std;
+
+// Flat AST
+struct ASTFlatTraits {
+    ASTKind kind(const ASTNode* node) const { return node->kind; }
+    Symbol value(const ASTNode* node) const { return node->value; }
+    TokenType token(const ASTNode*) const { return INVALID; }
+    const vector<ASTNode*>& children(const ASTNode* node) const { return node->children; }
+};
+
+FlatTree<ASTKind> flattenAST(const ASTNode* root) {
+    return flattenTree<ASTKind>(root, ASTFlatTraits());
+}
+
+// Same output as ASTNode::printTree, as one pass over the arrays
+void printFlatAST(const FlatTree<ASTKind>& tree) {
+    for (FlatIndex i = 0; i < tree.size(); i++) {
+        cout << string(tree.depth[i] * 2, ' ') << astKindName(tree.kind[i]);
+        if (tree.value[i] != EMPTY_SYMBOL) {
+            cout << " (" << symbolText(tree.value[i]) << ")";
+        }
+        cout << endl;
+    }
+}
+
+// A declared variable, indexed by its symbol ID
+struct SymbolInfo {
+    Symbol name;
+    ValueType type;                      // element type for arrays
+    vector<int64_t> dimensions;          // empty for scalars
+    const DeclarationNode* declaration;
+};
+
+// What resolve() found, in side tables indexed by node ID so later phases
+// never look a name up again
+struct SemanticInfo {
+    vector<int32_t> symbolOf;    // Declaration, Identifier, Index: symbol ID, -1 if none
+    vector<ValueType> typeOf;    // expressions: (element) type, UNKNOWN for statements and bad expressions
+    vector<uint32_t> rankOf;     // Identifier, Index: dimensions not subscripted yet, 0 for scalars
+    vector<SymbolInfo> symbols;  // by symbol ID
+};
+
+// Semantic analyzer that makes an AST and checks stuff
+class SemanticAnalyzer {
+private:
+    ASTBuilder builder;
+    Diagnostics& diagnostics;
+
+    // Names of the program being resolved. It's a table of its own: the
+    // lexer's table holds every identifier at block 0, declared or not.
+    // Record indexes are the symbol IDs.
+    SymbolTable scopes;
+    SemanticInfo info;
+    uint32_t loopDepth;
+
+    // Errors point at the node's token; ASTs made from the CST have no
+    // positions (see parser_incremental.cpp), so theirs print without one
+    void semanticError(const ASTNode* node, const string& message) {
+        diagnostics.report(DiagnosticKind::SEMANTIC, message, string_view(), node->line(), node->column());
+    }
+
+    static ValueType basicType(Symbol basic) {
+        string_view name = symbolText(basic);
+        if (name == "int") return ValueType::INT;
+        if (name == "float") return ValueType::FLOAT;
+        if (name == "char") return ValueType::CHAR;
+        if (name == "void") return ValueType::VOID;
+        return ValueType::UNKNOWN;
+    }
+
+    string nameOf(const ASTNode* expr) const {
+        return string(symbolText(info.symbols[info.symbolOf[expr->id]].name));
+    }
+
+    // Bind a use to the innermost declaration in scope, reporting it if
+    // there is none. Returns the symbol ID or -1.
+    int checkVariableDeclared(const ASTNode* use) {
+        int symbol = scopes.lookup(use->value);
+        if (symbol < 0) {
+            semanticError(use, "Variable '" + string(symbolText(use->value)) + "' is not declared");
+        }
+        return symbol;
+    }
+
+    // Decl: basic type, array sizes, and a new symbol in the current block
+    void declare(DeclarationNode* decl) {
+        string name(symbolText(decl->name()));
+        TypeNode* type = decl->type();
+        SymbolInfo symbol{decl->name(), basicType(type->basic()), {}, decl};
+        string typeText(symbolText(type->basic()));
+        for (ASTNode* size : type->children) {
+            int64_t count = astCast<IntegerNode>(size)->number;
+            if (count <= 0) {
+                semanticError(decl, "Array '" + name + "' must have a positive size");
+            }
+            symbol.dimensions.push_back(count);
+            typeText += "[" + string(symbolText(size->value)) + "]";
+        }
+        if (symbol.type == ValueType::VOID) {
+            semanticError(decl, "Variable '" + name + "' declared void");
+        }
+        if (!scopes.insert(decl->name(), IDENTIFIER, decl->name(), decl->line(), decl->column(), (int)name.length())) {
+            semanticError(decl, "Variable '" + name + "' is already declared in this block");
+            return;
+        }
+        scopes.setType(name, typeText);
+        info.symbolOf[decl->id] = (int32_t)info.symbols.size();
+        info.symbols.push_back(std::move(symbol));
+    }
+
+    // Operands, conditions and both sides of '=' need a single value.
+    // Subexpressions that already failed pass quietly, one error is enough.
+    bool scalar(const ASTNode* expr) {
+        if (info.typeOf[expr->id] == ValueType::UNKNOWN) return false;
+        if (info.rankOf[expr->id] > 0) {
+            semanticError(expr, "Array '" + nameOf(expr) + "' is used without all of its subscripts");
+            return false;
+        }
+        return true;
+    }
+
+    // On the way down, before the children
+    void enter(ASTNode* node) {
+        switch (node->kind) {
+            case ASTKind::BLOCK:
+                scopes.enterBlock();
+                break;
+            case ASTKind::DECLARATION:
+                declare(static_cast<DeclarationNode*>(node));
+                break;
+            case ASTKind::WHILE:
+            case ASTKind::DO_WHILE:
+                loopDepth++;
+                break;
+            case ASTKind::BREAK:
+                if (loopDepth == 0) semanticError(node, "break outside of a loop");
+                break;
+            case ASTKind::IDENTIFIER: {
+                int symbol = checkVariableDeclared(node);
+                if (symbol >= 0) {
+                    info.symbolOf[node->id] = symbol;
+                    info.typeOf[node->id] = info.symbols[symbol].type;
+                    info.rankOf[node->id] = (uint32_t)info.symbols[symbol].dimensions.size();
+                }
+                break;
+            }
+            case ASTKind::INTEGER:
+                info.typeOf[node->id] = ValueType::INT;
+                break;
+            case ASTKind::REAL:
+                info.typeOf[node->id] = ValueType::FLOAT;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // On the way up, once the children are typed
+    void leave(ASTNode* node) {
+        switch (node->kind) {
+            case ASTKind::BLOCK:
+                scopes.exitBlock();
+                break;
+            case ASTKind::WHILE:
+                loopDepth--;
+                scalar(static_cast<WhileNode*>(node)->condition());
+                break;
+            case ASTKind::DO_WHILE:
+                loopDepth--;
+                scalar(static_cast<DoWhileNode*>(node)->condition());
+                break;
+            case ASTKind::IF:
+                scalar(static_cast<IfNode*>(node)->condition());
+                break;
+            case ASTKind::ASSIGN: {
+                AssignNode* assign = static_cast<AssignNode*>(node);
+                scalar(assign->target());
+                scalar(assign->expression());
+                break;
+            }
+            case ASTKind::BINARY_OP: {
+                BinaryOpNode* binary = static_cast<BinaryOpNode*>(node);
+                bool left = scalar(binary->left());
+                bool right = scalar(binary->right());
+                if (!left || !right) break;
+                bool arithmetic = binary->op >= BinaryOp::ADD;
+                bool isFloat = info.typeOf[binary->left()->id] == ValueType::FLOAT ||
+                               info.typeOf[binary->right()->id] == ValueType::FLOAT;
+                info.typeOf[node->id] = arithmetic && isFloat ? ValueType::FLOAT : ValueType::INT;
+                break;
+            }
+            case ASTKind::UNARY_OP: {
+                UnaryOpNode* unary = static_cast<UnaryOpNode*>(node);
+                if (!scalar(unary->operand())) break;
+                bool isFloat = info.typeOf[unary->operand()->id] == ValueType::FLOAT;
+                info.typeOf[node->id] = unary->op == UnaryOp::NEGATE && isFloat ? ValueType::FLOAT : ValueType::INT;
+                break;
+            }
+            case ASTKind::INDEX: {
+                IndexNode* index = static_cast<IndexNode*>(node);
+                ASTNode* base = index->base();
+                if (scalar(index->subscript()) && info.typeOf[index->subscript()->id] == ValueType::FLOAT) {
+                    semanticError(node, "Array subscript is not an integer");
+                }
+                if (info.typeOf[base->id] == ValueType::UNKNOWN) break;
+                if (info.rankOf[base->id] == 0) {
+                    semanticError(node, "Subscripted value '" + nameOf(base) + "' is not an array");
+                    break;
+                }
+                info.symbolOf[node->id] = info.symbolOf[base->id];
+                info.typeOf[node->id] = info.typeOf[base->id];
+                info.rankOf[node->id] = info.rankOf[base->id] - 1;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void errorchecking() {
+      cout << "Error here" << endl;
+    }
+
+    // Child i of a CST node, or nullptr if it has fewer children
+    static CSTNode* childAt(CSTNode* node, size_t i) {
+        CSTChildren children = node->getChildren();
+        return i < children.size() ? children[i] : nullptr;
+    }
+
+    // Terminal of a CST node: value of child i
+    static Symbol symbolAt(CSTNode* node, size_t i) {
+        CSTNode* child = childAt(node, i);
+        return child ? child->getSymbol() : EMPTY_SYMBOL;
+    }
+
+    // Transform CST to AST. The CST is what the grammar needs, the AST keeps
+    // only what later phases need; shapes are documented on ASTBuilder. Like
+    // resolve(), the walk keeps its own stack, so deep trees are fine: a CST
+    // node first lists the children its AST node is made from, and once
+    // those are built they are on top of `built` for buildNode().
+    ASTNode* transformToAST(CSTNode* cstRoot) {
+        vector<pair<CSTNode*, size_t>> stack; // node, where its parts start in built (SIZE_MAX: not yet entered)
+        vector<ASTNode*> built;
+        vector<CSTNode*> parts;
+        stack.push_back(make_pair(cstRoot, SIZE_MAX));
+        while (!stack.empty()) {
+            CSTNode* node = stack.back().first;
+            size_t first = stack.back().second;
+            stack.pop_back();
+            if (!node) {
+                built.push_back(nullptr);
+                continue;
+            }
+            if (first != SIZE_MAX) {
+                ASTNode* result = buildNode(node, built.data() + first, built.size() - first);
+                built.resize(first);
+                built.push_back(result);
+                continue;
+            }
+
+            parts.clear();
+            partsOf(node, parts);
+            stack.push_back(make_pair(node, built.size()));
+            for (size_t i = parts.size(); i-- > 0;) {
+                stack.push_back(make_pair(parts[i], SIZE_MAX));
+            }
+        }
+        return built.back();
+    }
+
+    // The CST children an AST node is built from, in order
+    void partsOf(CSTNode* cstNode, vector<CSTNode*>& parts) {
+        switch (cstNode->getType()) {
+            // Program -> basic main ( ) Block
+            case NodeType::PROGRAM:
+                parts.push_back(childAt(cstNode, 4));
+                break;
+
+            // Decls -> Decl Decls',  Decls' -> Decl Decls' | ε  and  Stmts -> Stmt Stmts?
+            case NodeType::BLOCK:
+                for (CSTNode* child : cstNode->getChildren()) {
+                    if (child->getType() == NodeType::DECLS) {
+                        for (CSTNode* list = child; list && childAt(list, 1); list = childAt(list, 1)) {
+                            parts.push_back(childAt(list, 0));
+                        }
+                    } else if (child->getType() == NodeType::STMTS) {
+                        for (CSTNode* list = child; list; list = childAt(list, 1)) {
+                            parts.push_back(childAt(list, 0));
+                        }
+                    }
+                }
+                break;
+
+            case NodeType::STMT:
+                statementParts(cstNode, parts);
+                break;
+
+            // Loc -> id Loc',  Loc' -> [ Bool ] Loc'
+            case NodeType::LOC:
+                for (CSTNode* index = childAt(cstNode, 1); index; index = childAt(index, 3)) {
+                    parts.push_back(childAt(index, 1));
+                }
+                break;
+
+            // One operator each: [left, op, right]
+            case NodeType::BOOL:
+            case NodeType::JOIN:
+            case NodeType::EQUALITY:
+            case NodeType::REL:
+                parts.push_back(childAt(cstNode, 0));
+                parts.push_back(childAt(cstNode, 2));
+                break;
+
+            // Any number of operators: [t, op, t, op, t ...]
+            case NodeType::EXPR:
+            case NodeType::TERM: {
+                CSTChildren children = cstNode->getChildren();
+                for (size_t i = 0; i < children.size(); i += 2) {
+                    parts.push_back(children[i]);
+                }
+                break;
+            }
+
+            // Unary -> ! Unary | - Unary | Factor
+            case NodeType::UNARY:
+                parts.push_back(childAt(cstNode, cstNode->getChildren().size() == 2 ? 1 : 0));
+                break;
+
+            // Factor -> ( Bool ), the parentheses are gone in the AST
+            case NodeType::FACTOR:
+                parts.push_back(childAt(cstNode, 1));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    ASTNode* buildNode(CSTNode* cstNode, ASTNode** part, size_t count) {
+        switch (cstNode->getType()) {
+            case NodeType::PROGRAM:
+                return builder.program(part[0]);
+
+            case NodeType::BLOCK: {
+                ASTNode* blockNode = builder.block();
+                for (size_t k = 0; k < count; k++) {
+                    builder.append(blockNode, part[k]);
+                }
+                return blockNode;
+            }
+
+            // Decl -> Type id ;  with Type -> basic Type' and Type' -> [ num ] Type' | ε
+            case NodeType::DECL: {
+                CSTNode* typeNode = childAt(cstNode, 0);
+                ASTNode* type = builder.type(symbolAt(typeNode, 0));
+                for (CSTNode* dims = childAt(typeNode, 1); dims && childAt(dims, 1); dims = childAt(dims, 3)) {
+                    builder.addDimension(type, symbolAt(dims, 1));
+                }
+                return builder.declaration(symbolAt(cstNode, 1), type);
+            }
+
+            case NodeType::STMT:
+                return buildStatement(cstNode, part, count);
+
+            case NodeType::LOC: {
+                ASTNode* loc = builder.identifier(symbolAt(cstNode, 0));
+                for (size_t k = 0; k < count; k++) {
+                    loc = builder.index(loc, part[k]);
+                }
+                return loc;
+            }
+
+            case NodeType::BOOL:
+            case NodeType::JOIN:
+            case NodeType::EQUALITY:
+            case NodeType::REL:
+                return builder.binary(childAt(cstNode, 1)->getTokenType(), part[0], part[1]);
+
+            // Left associative
+            case NodeType::EXPR:
+            case NodeType::TERM: {
+                ASTNode* left = part[0];
+                for (size_t k = 1; k < count; k++) {
+                    left = builder.binary(childAt(cstNode, 2 * k - 1)->getTokenType(), left, part[k]);
+                }
+                return left;
+            }
+
+            case NodeType::UNARY:
+                if (cstNode->getChildren().size() == 2) {
+                    return builder.unary(childAt(cstNode, 0)->getTokenType(), part[0]);
+                }
+                return part[0];
+
+            case NodeType::FACTOR:
+                return part[0];
+
+            case NodeType::TERMINAL:
+                if (cstNode->getTokenType() == INTEGER) return builder.integer(cstNode->getSymbol());
+                if (cstNode->getTokenType() == REAL) return builder.real(cstNode->getSymbol());
+                if (cstNode->getTokenType() == IDENTIFIER) return builder.identifier(cstNode->getSymbol());
+                return nullptr;
+
+            default:
+                return nullptr;
+        }
+    }
+
+    // Productions 7-13. The keyword itself isn't in the CST for if, while,
+    // do and break, so the statement kind comes from the children.
+    void statementParts(CSTNode* stmt, vector<CSTNode*>& parts) {
+        CSTNode* first = childAt(stmt, 0);
+        switch (first->getType()) {
+            // Loc = Bool ;
+            case NodeType::LOC:
+                parts.push_back(first);
+                parts.push_back(childAt(stmt, 2));
+                return;
+
+            // do Stmt while ( Bool ) ;
+            case NodeType::STMT:
+                parts.push_back(first);
+                parts.push_back(childAt(stmt, 3));
+                return;
+
+            case NodeType::BLOCK:
+                parts.push_back(first);
+                return;
+
+            default:
+                break;
+        }
+
+        // if ( Bool ) Stmt Stmt'   or   while ( Bool ) Stmt
+        if (first->getTokenType() == LEFT_PAREN) {
+            parts.push_back(childAt(stmt, 1));
+            parts.push_back(childAt(stmt, 3));
+            CSTNode* elsePart = childAt(stmt, 4);
+            if (elsePart && childAt(elsePart, 0)->getType() != NodeType::EPSILON) {
+                parts.push_back(childAt(elsePart, 1));
+            }
+        }
+    }
+
+    ASTNode* buildStatement(CSTNode* stmt, ASTNode** part, size_t count) {
+        CSTNode* first = childAt(stmt, 0);
+        switch (first->getType()) {
+            case NodeType::LOC:
+                return builder.assign(part[0], part[1]);
+
+            case NodeType::STMT: {
+                ASTNode* loop = builder.doWhile();
+                builder.addBody(loop, part[0]);
+                builder.addBody(loop, part[1]);
+                return loop;
+            }
+
+            case NodeType::BLOCK:
+                return part[0];
+
+            default:
+                break;
+        }
+
+        switch (first->getTokenType()) {
+            case LEFT_PAREN: {
+                if (stmt->getChildren().size() == 5) {
+                    ASTNode* ifNode = builder.ifStmt(part[0]);
+                    builder.addBody(ifNode, part[1]);
+                    if (count == 3) builder.addBody(ifNode, part[2]);
+                    return ifNode;
+                }
+                ASTNode* loop = builder.whileStmt(part[0]);
+                builder.addBody(loop, part[1]);
+                return loop;
+            }
+
+            // return num ;
+            case RETURN:
+                return builder.returnStmt(builder.integer(symbolAt(stmt, 1)));
+
+            // break ;
+            case SEMICOLON:
+                return builder.breakStmt();
+
+            default:
+                return nullptr;
+        }
+    }
+
+public:
+    explicit SemanticAnalyzer(Diagnostics& diags) : diagnostics(diags), loopDepth(0) {}
+
+    // This is the main function to analyze the CST. Problems go to the
+    // diagnostics, nullptr comes back only when there was nothing to analyze.
+    ASTNode* analyze(CSTNode* cstRoot) {
+        if (!cstRoot) {
+            diagnostics.report(DiagnosticKind::SEMANTIC, "Empty syntax tree");
+            return nullptr;
+        }
+        return transformToAST(cstRoot);
+    }
+
+    // Names and types in one pass over the AST. Declarations go into the
+    // scoped table as they come, every use is bound to the innermost one,
+    // and expression types are worked out bottom-up. Nodes are numbered in
+    // preorder on the way down. The walk keeps its own stack, so deep trees
+    // are fine. Problems go to the diagnostics.
+    const SemanticInfo& resolve(ASTNode* root) {
+        info = SemanticInfo();
+        scopes = SymbolTable();
+        loopDepth = 0;
+        if (!root) return info;
+
+        vector<pair<ASTNode*, bool>> stack; // node, children done
+        stack.push_back(make_pair(root, false));
+        while (!stack.empty()) {
+            ASTNode* node = stack.back().first;
+            bool leaving = stack.back().second;
+            stack.pop_back();
+            if (leaving) {
+                leave(node);
+                continue;
+            }
+
+            node->id = (uint32_t)info.typeOf.size();
+            info.symbolOf.push_back(-1);
+            info.typeOf.push_back(ValueType::UNKNOWN);
+            info.rankOf.push_back(0);
+            enter(node);
+
+            stack.push_back(make_pair(node, true));
+            for (size_t i = node->children.size(); i-- > 0;) {
+                if (node->children[i] != nullptr) {
+                    stack.push_back(make_pair(node->children[i], false));
+                }
+            }
+        }
+        return info;
+    }
+
+    const SemanticInfo& semanticInfo() const { return info; }
+};
+
+// tac_generator.cpp includes this file for the front end and has its own main
+#ifndef SEMANTIC_PHASE_3_NO_MAIN
+
+// Test the semantic analyzer
+// Usage: semantic_phase_3 [--cst] [file]. Without a file the built-in sample
+// is used. The AST is built straight from the parser; --cst goes through the
+// CST instead and prints it too, for debugging the grammar.
+int main(int argc, char* argv[]) {
+    SymbolTable symbolTable;
+
+    // Testing this mess
+    string code = R"(
+    int main() {
+    int a; int b; int c;
+    a = 3;
+    b = 5;
+    c = b - a;
+    b = a + c;
+    c = b - a;
+    return 0;
+    }
+    )";
+
+    bool viaCST = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--cst") viaCST = true;
+        else path = argv[i];
+    }
+
+    SourceFile file;
+    if (path && !file.open(path)) return 1;
+    string_view source = path ? file.text() : string_view(code);
+
+    // Files are streamed: the parser pulls tokens straight out of the mapped
+    // buffer. The sample is lexed up front so the tokens can be printed.
+    Lexer lex(source);
+    vector<Token> tokens;
+    if (!path) {
+        tokens = lexer(code, symbolTable);
+        cout << "Tokens:" << endl;
+        printTokens(tokens, code);
+    }
+
+    Arena cstArena; // owns the whole CST
+    Diagnostics diagnostics;
+    Parser parser = path ? Parser(lex, source, symbolTable, cstArena, diagnostics)
+                         : Parser(tokens, source, symbolTable, cstArena, diagnostics);
+
+    ASTNode* ast = nullptr;
+    SemanticAnalyzer analyzer(diagnostics);
+    if (viaCST) {
+        CSTNode* syntaxTree = parser.parse();
+        if (!diagnostics.hasErrors()) {
+            cout << "\nConcrete Syntax Tree:" << endl;
+            printFlatCST(flattenCST(syntaxTree));
+            ast = analyzer.analyze(syntaxTree);
+        }
+    } else {
+        ASTBuilder builder;
+        ast = parser.parseAST(builder);
+    }
+
+    // Semantic analysis, on a tree the parser had no trouble with
+    if (!diagnostics.hasErrors()) {
+        analyzer.resolve(ast);
+    }
+
+    // Every error of the file at once, not just the first
+    if (diagnostics.hasErrors()) {
+        diagnostics.print(cerr);
+        delete ast;
+        return 1;
+    }
+    cout << "\nAbstract Syntax Tree:" << endl;
+    printFlatAST(flattenAST(ast));
+
+    // Clean up time (the CST goes with cstArena)
+    delete ast;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_FILE_MMAP 1
+#endif
+using namespace std;
+
+// Read-only view of a source file. On POSIX the file is mmapped, so the lexer
+// reads straight from the page cache and the program text is never copied.
+// Elsewhere it falls back to reading the file into a string.
+class SourceFile {
+  const char* data;
+  size_t size;
+  bool mapped;
+  string contents; // only used by the read fallback
+
+public:
+  SourceFile() {
+    data = NULL;
+    size = 0;
+    mapped = false;
+  }
+
+  SourceFile(const SourceFile&) = delete;
+  SourceFile& operator=(const SourceFile&) = delete;
+
+  ~SourceFile() {
+    close();
+  }
+
+  // Open a file, returns false (and prints why) if it can't be read
+  bool open(const string& path) {
+    close();
+#ifdef SOURCE_FILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      cerr << "Error: cannot open '" << path << "'" << endl;
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      cerr << "Error: cannot stat '" << path << "'" << endl;
+      ::close(fd);
+      return false;
+    }
+    // Token offsets are 32-bit
+    if ((uint64_t)st.st_size > UINT32_MAX) {
+      cerr << "Error: '" << path << "' is larger than 4 GiB" << endl;
+      ::close(fd);
+      return false;
+    }
+    size = (size_t)st.st_size;
+    if (size > 0) {
+      void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        cerr << "Error: cannot map '" << path << "'" << endl;
+        ::close(fd);
+        size = 0;
+        return false;
+      }
+      madvise(p, size, MADV_SEQUENTIAL); // the lexer reads front to back once
+      data = static_cast<const char*>(p);
+      mapped = true;
+    }
+    ::close(fd); // the mapping stays valid after close
+    return true;
+#else
+    ifstream in(path, ios::binary);
+    if (!in) {
+      cerr << "Error: cannot open '" << path << "'" << endl;
+      return false;
+    }
+    stringstream buffer;
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    if ((uint64_t)contents.size() > UINT32_MAX) {
+      cerr << "Error: '" << path << "' is larger than 4 GiB" << endl;
+      contents.clear();
+      return false;
+    }
+    data = contents.data();
+    size = contents.size();
+    return true;
+#endif
+  }
+
+  void close() {
+#ifdef SOURCE_FILE_MMAP
+    if (mapped) {
+      munmap(const_cast<char*>(data), size);
+    }
+#endif
+    contents.clear();
+    data = NULL;
+    size = 0;
+    mapped = false;
+  }
+
+  string_view text() const {
+    return string_view(data, size);
+  }
+};
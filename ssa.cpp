@@ -0,0 +1,395 @@
+#include "optimizer.h"
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Into and out of SSA form. Phis go on the iterated dominance frontiers of
+// the blocks writing a name (Cytron et al.), pruned to the blocks where
+// liveness says the name is live on entry, so a variable that dies at a
+// join gets no phi there. The frontiers come from the dominator tree the
+// CFG already has: walking up from each predecessor of a join to the
+// join's immediate dominator (Cooper, Harvey and Kennedy), which touches
+// each frontier entry once. Renaming then walks the dominator tree keeping
+// the latest version of each name, with an undo log to put it back when a
+// subtree is done. All of it is linear in the code plus the frontiers.
+//
+// Coming out, a phi becomes one copy per incoming edge at the end of the
+// predecessor. The copies of one edge happen at once (t5 = t3 and t3 = t5
+// swap), so they're put in an order where nothing is overwritten before
+// it's read, with a temp to break a cycle. An edge from a conditional
+// jump to a block with phis gets a block of its own at the end of the
+// code, so the copies run only when the jump is taken.
+//
+// The entry has to have no predecessors for any of this to work: a loop
+// back to it would be a join with no edge carrying the value the name
+// came in with. When the code starts with a label, it gets a block of its
+// own in front, a jump to that label, which the copies for the loop's
+// phis go into and which is dropped again on the way out.
+// ---------------------------------------------------------------------------
+
+static TACProgram withEntry(TACProgram program, bool add) {
+    if (add) program.code.insert(program.code.begin(), TACInstruction(TACOp::JUMP, ValueType::VOID, program.code[0].result));
+    return program;
+}
+
+SSAForm::SSAForm(TACProgram source)
+    : addedEntry(!source.code.empty() && source.code[0].op == TACOp::LABEL),
+      program(withEntry(std::move(source), addedEntry)), cfg(program) {
+    // Arrays are written an element at a time and stay as they are; so do
+    // temps written once, which are already single assignment
+    uint32_t variableCount = (uint32_t)program.variables.size();
+    vector<uint32_t> writes(program.temps.size(), 0);
+    for (const TACInstruction& in : program.code) {
+        TACOperand written = writtenBy(in);
+        if (written.is(TACOperand::TEMP)) writes[written.index()]++;
+    }
+    vector<bool> renamed(variableCount + program.temps.size(), false);
+    for (uint32_t v = 0; v < variableCount; v++) {
+        renamed[v] = program.variables[v].dimensions.empty();
+    }
+    for (uint32_t t = 0; t < program.temps.size(); t++) {
+        renamed[variableCount + t] = writes[t] > 1;
+    }
+
+    // Predecessor lists are filled in block order, the same order succ is
+    predecessorIndex.resize(cfg.succ.size());
+    vector<uint32_t> fill(cfg.size(), 0);
+    for (BlockId b = 0; b < cfg.size(); b++) {
+        for (uint32_t e = cfg.succStart[b]; e < cfg.succStart[b + 1]; e++) {
+            predecessorIndex[e] = fill[cfg.succ[e]]++;
+        }
+    }
+
+    placePhis(renamed);
+    rename(renamed);
+}
+
+void SSAForm::placePhis(const vector<bool>& renamed) {
+    size_t count = cfg.size();
+    Liveness liveness(program, cfg);
+
+    // Dominance frontiers, as (block, frontier block) pairs sorted by block
+    vector<pair<BlockId, BlockId>> pairs;
+    vector<BlockId> lastJoin(count, NO_BLOCK);
+    for (BlockId join : cfg.order) {
+        if (cfg.predecessors(join).size() < 2) continue;
+        for (BlockId p : cfg.predecessors(join)) {
+            if (!cfg.reachable(p)) continue;
+            for (BlockId runner = p; runner != cfg.idom[join] && lastJoin[runner] != join; runner = cfg.idom[runner]) {
+                lastJoin[runner] = join;
+                pairs.push_back({runner, join});
+            }
+        }
+    }
+    vector<uint32_t> frontierStart(count + 1, 0);
+    for (const pair<BlockId, BlockId>& entry : pairs) {
+        frontierStart[entry.first + 1]++;
+    }
+    for (size_t b = 0; b < count; b++) {
+        frontierStart[b + 1] += frontierStart[b];
+    }
+    vector<BlockId> frontier(pairs.size());
+    vector<uint32_t> fill(frontierStart.begin(), frontierStart.end() - 1);
+    for (const pair<BlockId, BlockId>& entry : pairs) {
+        frontier[fill[entry.first]++] = entry.second;
+    }
+
+    // Blocks writing each renamed name that crosses blocks, by slot
+    pairs.clear();
+    for (BlockId b : cfg.order) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            TACOperand written = writtenBy(program.code[i]);
+            uint32_t s = liveness.slot(written);
+            if (s == Liveness::NO_SLOT || !renamed[liveness.nameIndex(written)]) continue;
+            if (pairs.empty() || pairs.back() != make_pair((BlockId)s, b)) pairs.push_back({s, b});
+        }
+    }
+    vector<uint32_t> writerStart(liveness.slotCount() + 1, 0);
+    for (const pair<BlockId, BlockId>& entry : pairs) {
+        writerStart[entry.first + 1]++;
+    }
+    for (size_t s = 0; s < liveness.slotCount(); s++) {
+        writerStart[s + 1] += writerStart[s];
+    }
+    vector<BlockId> writers(pairs.size());
+    fill.assign(writerStart.begin(), writerStart.end() - 1);
+    for (const pair<BlockId, BlockId>& entry : pairs) {
+        writers[fill[entry.first]++] = entry.second;
+    }
+
+    // Iterated frontier of each name's writers, stamped with the slot so
+    // the marks needn't be cleared between names
+    pairs.clear(); // now (block, slot) for each phi
+    vector<uint32_t> hasPhi(count, Liveness::NO_SLOT);
+    vector<uint32_t> queued(count, Liveness::NO_SLOT);
+    vector<BlockId> work;
+    for (uint32_t s = 0; s < liveness.slotCount(); s++) {
+        work.assign(writers.begin() + writerStart[s], writers.begin() + writerStart[s + 1]);
+        for (BlockId b : work) {
+            queued[b] = s;
+        }
+        while (!work.empty()) {
+            BlockId b = work.back();
+            work.pop_back();
+            for (uint32_t f = frontierStart[b]; f < frontierStart[b + 1]; f++) {
+                BlockId join = frontier[f];
+                if (hasPhi[join] == s) continue;
+                hasPhi[join] = s;
+                if (!liveness.liveIn(join, s)) continue;
+                pairs.push_back({join, s});
+                if (queued[join] != s) {
+                    queued[join] = s;
+                    work.push_back(join);
+                }
+            }
+        }
+    }
+
+    // By block, in slot order within a block
+    phiStart.assign(count + 1, 0);
+    for (const pair<BlockId, uint32_t>& entry : pairs) {
+        phiStart[entry.first + 1]++;
+    }
+    for (size_t b = 0; b < count; b++) {
+        phiStart[b + 1] += phiStart[b];
+    }
+    phis.resize(pairs.size());
+    fill.assign(phiStart.begin(), phiStart.end() - 1);
+    for (const pair<BlockId, uint32_t>& entry : pairs) {
+        phis[fill[entry.first]++].name = liveness.name(entry.second);
+    }
+    for (BlockId b = 0; b < count; b++) {
+        for (uint32_t p = phiStart[b]; p < phiStart[b + 1]; p++) {
+            phis[p].firstArgument = (uint32_t)arguments.size();
+            arguments.resize(arguments.size() + cfg.predecessors(b).size());
+        }
+    }
+    stats.phis = phis.size();
+}
+
+void SSAForm::rename(const vector<bool>& renamed) {
+    // Latest version of each name on the way down the tree, none while
+    // it still has the value it came in with
+    vector<TACOperand> current(renamed.size());
+    vector<pair<uint32_t, TACOperand>> undo;
+
+    auto latest = [&](TACOperand name) {
+        TACOperand version = current[nameIndex(program, name)];
+        return version.none() ? name : version;
+    };
+    auto define = [&](TACOperand name) {
+        uint32_t n = nameIndex(program, name);
+        ValueType type = name.is(TACOperand::TEMP) ? program.temps[name.index()] : program.variables[n].type;
+        program.temps.push_back(type);
+        TACOperand version = TACOperand::temp((uint32_t)program.temps.size() - 1);
+        undo.push_back({n, current[n]});
+        current[n] = version;
+        stats.versions++;
+        return version;
+    };
+    auto read = [&](TACOperand& operand) {
+        if ((operand.is(TACOperand::VARIABLE) || operand.is(TACOperand::TEMP)) && renamed[nameIndex(program, operand)]) {
+            operand = latest(operand);
+        }
+    };
+
+    if (cfg.size() == 0) return;
+    vector<pair<BlockId, size_t>> stack; // block, undo log size on entry (SIZE_MAX: not yet entered)
+    stack.push_back({0, SIZE_MAX});
+    while (!stack.empty()) {
+        BlockId b = stack.back().first;
+        size_t mark = stack.back().second;
+        stack.pop_back();
+        if (mark != SIZE_MAX) {
+            for (; undo.size() > mark; undo.pop_back()) {
+                current[undo.back().first] = undo.back().second;
+            }
+            continue;
+        }
+        stack.push_back({b, undo.size()});
+
+        for (uint32_t p = phiStart[b]; p < phiStart[b + 1]; p++) {
+            phis[p].result = define(phis[p].name);
+        }
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            TACInstruction& in = program.code[i];
+            read(in.a);
+            read(in.b);
+            TACOperand written = writtenBy(in);
+            if (!written.none() && renamed[nameIndex(program, written)]) in.result = define(written);
+        }
+        for (uint32_t e = cfg.succStart[b]; e < cfg.succStart[b + 1]; e++) {
+            BlockId s = cfg.succ[e];
+            for (uint32_t p = phiStart[s]; p < phiStart[s + 1]; p++) {
+                arguments[phis[p].firstArgument + predecessorIndex[e]] = latest(phis[p].name);
+            }
+        }
+        for (BlockId child : cfg.dominatorChildren(b)) {
+            stack.push_back({child, SIZE_MAX});
+        }
+    }
+}
+
+void SSAForm::print(ostream& out) const {
+    for (BlockId b = 0; b < cfg.size(); b++) {
+        uint32_t i = cfg.blocks[b].begin;
+        for (; i < cfg.blocks[b].end && program.code[i].op == TACOp::LABEL; i++) {
+            program.print(out, program.code[i]);
+        }
+        for (const Phi* phi = phisBegin(b); phi != phisEnd(b); phi++) {
+            out << "    " << program.operandText(phi->result) << " = phi(";
+            for (size_t k = 0; k < cfg.predecessors(b).size(); k++) {
+                out << (k ? ", " : "") << program.operandText(argument(*phi, k));
+            }
+            out << ")" << endl;
+        }
+        for (; i < cfg.blocks[b].end; i++) {
+            program.print(out, program.code[i]);
+        }
+    }
+}
+
+// Copies that happen at once, in an order that reads every source before
+// it's overwritten. A copy can go once nothing still waiting reads its
+// destination; when only cycles are left, one destination is saved in a
+// temp and its readers read that instead.
+void SSAForm::sequentialize(vector<pair<TACOperand, TACOperand>>& copies, vector<TACInstruction>& code) {
+    auto emit = [&](TACOperand destination, TACOperand source) {
+        code.push_back(TACInstruction(TACOp::COPY, program.temps[destination.index()], destination, source));
+        stats.copies++;
+    };
+    if (copies.size() == 1) {
+        if (copies[0].first != copies[0].second) emit(copies[0].first, copies[0].second);
+        return;
+    }
+
+    unordered_map<uint32_t, uint32_t> readers;  // operand bits -> copies waiting that read it
+    unordered_map<uint32_t, size_t> writer;     // operand bits -> copy that writes it
+    vector<bool> done(copies.size(), false);
+    size_t waiting = 0;
+    for (size_t c = 0; c < copies.size(); c++) {
+        if (copies[c].first == copies[c].second) {
+            done[c] = true;
+            continue;
+        }
+        readers[copies[c].second.bits]++;
+        writer[copies[c].first.bits] = c;
+        waiting++;
+    }
+    vector<size_t> ready;
+    for (size_t c = 0; c < copies.size(); c++) {
+        if (!done[c] && readers.find(copies[c].first.bits) == readers.end()) ready.push_back(c);
+    }
+
+    // Waiting copies by what they read, to find the readers of a saved
+    // destination; a source only changes from a destination to its saved
+    // temp, once, so the order still finds them
+    vector<pair<uint32_t, size_t>> bySource;
+    size_t next = 0;
+    while (waiting > 0) {
+        while (!ready.empty()) {
+            size_t c = ready.back();
+            ready.pop_back();
+            emit(copies[c].first, copies[c].second);
+            done[c] = true;
+            waiting--;
+            if (--readers[copies[c].second.bits] > 0) continue;
+            auto freed = writer.find(copies[c].second.bits);
+            if (freed != writer.end() && !done[freed->second]) ready.push_back(freed->second);
+        }
+        if (waiting == 0) break;
+
+        if (bySource.empty()) {
+            for (size_t c = 0; c < copies.size(); c++) {
+                if (!done[c]) bySource.push_back({copies[c].second.bits, c});
+            }
+            sort(bySource.begin(), bySource.end());
+        }
+        for (; done[next]; next++) {
+        }
+        TACOperand destination = copies[next].first;
+        program.temps.push_back(program.temps[destination.index()]);
+        TACOperand saved = TACOperand::temp((uint32_t)program.temps.size() - 1);
+        emit(saved, destination);
+        stats.cycles++;
+        auto reader = lower_bound(bySource.begin(), bySource.end(), make_pair(destination.bits, (size_t)0));
+        for (; reader != bySource.end() && reader->first == destination.bits; reader++) {
+            if (done[reader->second]) continue;
+            copies[reader->second].second = saved;
+            readers[saved.bits]++;
+        }
+        readers[destination.bits] = 0;
+        ready.push_back(next);
+    }
+}
+
+TACProgram SSAForm::destruct() {
+    vector<TACInstruction> code;
+    vector<TACInstruction> edgeBlocks; // split edges, after the rest of the code
+    vector<pair<TACOperand, TACOperand>> copies;
+    code.reserve(program.code.size() + arguments.size());
+
+    auto edgeCopies = [&](uint32_t e) {
+        copies.clear();
+        BlockId s = cfg.succ[e];
+        for (uint32_t p = phiStart[s]; p < phiStart[s + 1]; p++) {
+            TACOperand source = arguments[phis[p].firstArgument + predecessorIndex[e]];
+            if (!source.none()) copies.push_back({phis[p].result, source});
+        }
+    };
+
+    for (BlockId b = 0; b < cfg.size(); b++) {
+        const TACInstruction& last = program.code[cfg.blocks[b].end - 1];
+        bool ends = last.isJump() || last.op == TACOp::RETURN;
+        code.insert(code.end(), program.code.begin() + cfg.blocks[b].begin,
+                    program.code.begin() + cfg.blocks[b].end - (ends ? 1 : 0));
+        uint32_t first = cfg.succStart[b];
+        uint32_t edges = cfg.succStart[b + 1] - first;
+        if (!cfg.reachable(b) || last.op == TACOp::RETURN || edges == 0) {
+            if (ends) code.push_back(last);
+            continue;
+        }
+        if (!last.isJump()) {
+            edgeCopies(first);
+            sequentialize(copies, code);
+            continue;
+        }
+
+        edgeCopies(first);
+        if (last.op == TACOp::JUMP || copies.empty()) {
+            sequentialize(copies, code);
+            if (!(addedEntry && b == 0)) code.push_back(last);
+        } else if (cfg.succ[first] == b + 1) {
+            // Taken or not, the branch lands on the next block
+            sequentialize(copies, code);
+        } else {
+            TACOperand label = TACOperand::label(program.labelCount++);
+            edgeBlocks.push_back(TACInstruction(TACOp::LABEL, ValueType::VOID, label));
+            sequentialize(copies, edgeBlocks);
+            edgeBlocks.push_back(TACInstruction(TACOp::JUMP, ValueType::VOID, last.result));
+            TACInstruction branch = last;
+            branch.result = label;
+            code.push_back(branch);
+            stats.splitEdges++;
+        }
+        if (last.op != TACOp::JUMP && edges == 2) {
+            edgeCopies(first + 1);
+            sequentialize(copies, code);
+        }
+    }
+
+    if (!edgeBlocks.empty()) {
+        // The split edges must not be fallen into from the end of the code
+        bool fallsOff = code.empty() || !(code.back().op == TACOp::JUMP || code.back().op == TACOp::RETURN);
+        TACOperand exit = TACOperand::label(program.labelCount);
+        if (fallsOff) {
+            program.labelCount++;
+            code.push_back(TACInstruction(TACOp::JUMP, ValueType::VOID, exit));
+        }
+        code.insert(code.end(), edgeBlocks.begin(), edgeBlocks.end());
+        if (fallsOff) code.push_back(TACInstruction(TACOp::LABEL, ValueType::VOID, exit));
+    }
+
+    TACProgram result = std::move(program);
+    result.code = std::move(code);
+    return result;
+}
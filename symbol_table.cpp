@@ -1,21 +1,30 @@
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "token.h"
+#include "interner.h"
 using namespace std;
 
 class Node {
-  string lexeme, token, value;
+  Symbol lexeme, value; // interned, see interner.h
+  TokenType token;
   string data_type; // added field for type (int, float, void, etc.)
   int block_id; // block number
   int line_number, char_start_num, length; // Preserved location information
-  Node* next;
+  int shadowed; // binding of the same lexeme this one hides, -1 if none
 
 public:
   Node() {
-    next = NULL;
+    lexeme = value = EMPTY_SYMBOL;
+    token = INVALID;
+    shadowed = -1;
     block_id = 0; // initial block id
   }
 
   // Node needs lexemes, token, lexeme value / lexeme itself, line number, character start number, and lexeme length
-  Node (string lexeme, string token, string value, int line_number, int char_start_num, int length) {
+  Node (Symbol lexeme, TokenType token, Symbol value, int line_number, int char_start_num, int length) {
     this->lexeme = lexeme;
     this->token = token;
     this->value = value;
@@ -24,14 +33,14 @@ public:
     this->line_number = line_number;
     this->char_start_num = char_start_num;
     this->length = length;
-    this->next = NULL;
+    this->shadowed = -1;
   }
 
   // FOR TESTING, COULD BE REMOVE WHEN USING THE PARSER
   void print() {
-    cout << " Lexeme: " << lexeme
-         << "\n Token: " << token
-         << "\n Token Value: " << value
+    cout << " Lexeme: " << symbolText(lexeme)
+         << "\n Token: " << tokenTypeName(token)
+         << "\n Token Value: " << symbolText(value)
          << "\n Data Type: " << data_type
          << "\n Block #: " << block_id
          << "\n Line #: " << line_number
@@ -41,27 +50,77 @@ public:
   friend class SymbolTable;
 };
 
+// Scoped symbol table. Every insert creates a binding record; records are
+// stored contiguously and never move, so a record index is a stable symbol
+// ID. An open-addressing (linear probing) table maps each interned lexeme to
+// the top of its binding stack, and each binding links to the one it shadows.
+// Entering a block pushes a scope; exiting pops exactly the bindings made in
+// it. Lookups are one probe and return the innermost visible binding.
 class SymbolTable {
-  Node* head[100];
+  struct Slot {
+    Symbol name;  // EMPTY_SYMBOL = empty slot
+    int32_t top;  // innermost visible binding, -1 if the name is out of scope
+  };
+
+  vector<Node> records;
+  vector<Slot> slots;         // size is always a power of two
+  size_t used;                // slots holding a name
+  vector<int> scopeBindings;  // bindings of all open scopes, innermost last
+  vector<size_t> scopeStarts; // where each open block's bindings begin
   int current_block;
 
+  size_t slotMask() const { return slots.size() - 1; }
+
+  // Fibonacci hashing spreads consecutive IDs across the table
+  size_t home(Symbol name) const {
+    return (size_t)((name * 0x9E3779B97F4A7C15ULL) >> 32) & slotMask();
+  }
+
+  // Slot holding this name, or the empty slot where it would go
+  size_t probe(Symbol name) const {
+    size_t i = home(name);
+    while (slots[i].name != EMPTY_SYMBOL && slots[i].name != name) {
+      i = (i + 1) & slotMask();
+    }
+    return i;
+  }
+
+  // Double the slot array once it is half full
+  void grow() {
+    vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size() * 2, Slot{EMPTY_SYMBOL, -1});
+    for (const Slot& slot : old) {
+      if (slot.name != EMPTY_SYMBOL) slots[probe(slot.name)] = slot;
+    }
+  }
+
 public:
   SymbolTable() {
-    for (int i = 0; i < 100; i++) {
-      head[i] = NULL;
-    }
+    slots.assign(64, Slot{EMPTY_SYMBOL, -1});
+    used = 0;
     current_block = 0; // initialize block number
   }
 
   // Block management
   void enterBlock() {
     current_block++;
+    scopeStarts.push_back(scopeBindings.size());
   }
 
+  // Pop the bindings made since the matching enterBlock(), O(bindings popped)
   void exitBlock() {
-    if (current_block > 0) {
-      current_block--;
+    if (current_block == 0) {
+      return;
+    }
+    size_t start = scopeStarts.back();
+    scopeStarts.pop_back();
+    while (scopeBindings.size() > start) {
+      const Node& binding = records[scopeBindings.back()];
+      scopeBindings.pop_back();
+      slots[probe(binding.lexeme)].top = binding.shadowed;
     }
+    current_block--;
   }
   // Get current block
   int getCurrentBlock() {
@@ -69,85 +128,84 @@ public:
   }
 
   // Modified insert to only store identifiers and keywords
-  bool insert(string lexeme, string token, string value, 
+  bool insert(Symbol lexeme, TokenType token, Symbol value,
               int line_no, int char_start_num, int length) {
     // Only store identifiers and keywords
-    if (token != "IDENTIFIER" && token != "KEYWORD") {
+    if ((token != IDENTIFIER && token != KEYWORD) || lexeme == EMPTY_SYMBOL) {
       return false;
     }
 
-    int index = getIndex(lexeme);
-    Node* newNode = new Node(lexeme, token, value, line_no, char_start_num, length);
-    newNode->block_id = current_block;
+    size_t i = probe(lexeme);
+    int index = (int)records.size();
+    int shadowed = -1;
 
-    if (head[index] == NULL) {
-      head[index] = newNode;
+    if (slots[i].name == EMPTY_SYMBOL) {
+      slots[i] = Slot{lexeme, -1};
+      used++;
     } else {
-      Node* current = head[index];
-      while (current->next != NULL) {
-        if (current->lexeme == lexeme && current->block_id == current_block) {
-          delete newNode;
-          return false; // Identifier already exists in the current block
-        }
-        current = current->next;
+      shadowed = slots[i].top;
+      // Only bindings of open scopes are visible, so the same depth means the same block
+      if (shadowed >= 0 && records[shadowed].block_id == current_block) {
+        return false; // Identifier already exists in the current block
       }
-      current->next = newNode;
+    }
+    slots[i].top = index;
+
+    records.push_back(Node(lexeme, token, value, line_no, char_start_num, length));
+    records.back().block_id = current_block;
+    records.back().shadowed = shadowed;
+    scopeBindings.push_back(index);
+
+    if (used * 2 > slots.size()) {
+      grow();
     }
     return true;
   }
 
-  // Set type for an identifier
-  bool setType(string lexeme, string type) {
-    int index = getIndex(lexeme);
-    Node* current = head[index];
+  bool insert(string_view lexeme, TokenType token, string_view value,
+              int line_no, int char_start_num, int length) {
+    return insert(intern(lexeme), token, intern(value), line_no, char_start_num, length);
+  }
 
-    while (current != NULL) {
-      if (current->lexeme == lexeme && 
-          current->block_id == current_block) {
-        current->data_type = type;
-        return true;
-      }
-      current = current->next;
+  // Innermost visible binding (a stable symbol ID), -1 if none is in scope
+  int lookup(Symbol lexeme) const {
+    return slots[probe(lexeme)].top;
+  }
+
+  // A name never interned can't be bound; EMPTY_SYMBOL is never bound
+  int lookup(string_view lexeme) const {
+    return lookup(stringPool().find(lexeme));
+  }
+
+  // Set type for an identifier declared in the current block
+  bool setType(string_view lexeme, const string& type) {
+    int binding = lookup(lexeme);
+    if (binding >= 0 && records[binding].block_id == current_block) {
+      records[binding].data_type = type;
+      return true;
     }
     return false;
   }
 
-  string find(string lexeme) {
-    int index = getIndex(lexeme);
-    Node* current = head[index];
-
-    for (int searchBlock = current_block; searchBlock >= 0; searchBlock--) {
-      Node* temp = current;
-      while (temp != NULL) {
-        if (temp->lexeme == lexeme && temp->block_id <= searchBlock) {
-          temp->print();
-          return temp->lexeme;
-        }
-        temp = temp->next;
-      }
+  string find(string_view lexeme) {
+    int binding = lookup(lexeme);
+    if (binding >= 0) {
+      records[binding].print();
+      return string(symbolText(records[binding].lexeme));
     }
     return "-1";
   }
 
-  string getType(string lexeme) {
-    int index = getIndex(lexeme);
-    Node* current = head[index];
-
-    while (current != NULL) {
-      if (current->lexeme == lexeme && 
-          current->block_id <= current_block) {
-        return current->data_type;
-      }
-      current = current->next;
+  string getType(string_view lexeme) {
+    int binding = lookup(lexeme);
+    if (binding >= 0) {
+      return records[binding].data_type;
     }
     return "unknown";
   }
 
-  int getIndex(string lexeme) {
-    int index = 0;
-    for (int i = 0; i < lexeme.length(); i++) {
-      index = index + lexeme[i];
-    }
-    return (index % 100);
+  // Number of records stored
+  size_t size() const {
+    return records.size();
   }
-};
\ No newline at end of file
+};
@@ -0,0 +1,179 @@
+#ifndef TAC_H
+#define TAC_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+// Three-address code. A program is one contiguous array of 16-byte
+// instructions; operands are tagged 32-bit indexes into the program's
+// temp, variable, constant and label tables, never strings, so the
+// optimizer passes walk plain arrays and compare operands as integers.
+
+enum class TACOp : uint8_t {
+    ADD, SUB, MUL, DIV,       // result = a op b
+    EQ, NE, LT, LE, GT, GE,   // result = a rel b, 1 or 0
+    NEG, NOT,                 // result = -a, !a
+    TO_FLOAT, TO_INT, TO_CHAR,// result = (type) a
+    COPY,                     // result = a
+    LOAD,                     // result = a[b], b a byte offset
+    STORE,                    // result[a] = b
+    LABEL,                    // result:
+    JUMP,                     // goto result
+    IF, IF_FALSE,             // if [not] (a condition b) goto result
+    RETURN                    // return a
+};
+
+// What IF and IF_FALSE test: a alone (non-zero), or a compared with b
+enum class TACCondition : uint8_t { TRUTH, EQ, NE, LT, LE, GT, GE };
+
+inline const char* tacOpText(TACOp op) {
+    static const char* const texts[] = {
+        "+", "-", "*", "/", "==", "!=", "<", "<=", ">", ">=", "-", "!",
+        "(float)", "(int)", "(char)", "=", "[]", "[]=", "label", "goto", "if", "ifFalse", "return"
+    };
+    return texts[static_cast<int>(op)];
+}
+
+inline const char* tacConditionText(TACCondition condition) {
+    static const char* const texts[] = {"", "==", "!=", "<", "<=", ">", ">="};
+    return texts[static_cast<int>(condition)];
+}
+
+// Operand: 2-bit kind over a 30-bit index
+class TACOperand {
+public:
+    enum Kind : uint32_t { TEMP = 0, VARIABLE = 1, CONSTANT = 2, LABEL = 3 };
+
+    static const uint32_t INDEX_BITS = 30;
+    static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static const uint32_t NONE_BITS = UINT32_MAX;
+
+    uint32_t bits;
+
+    TACOperand() : bits(NONE_BITS) {}
+
+    static TACOperand make(Kind kind, uint32_t index) {
+        TACOperand operand;
+        operand.bits = (static_cast<uint32_t>(kind) << INDEX_BITS) | (index & INDEX_MASK);
+        return operand;
+    }
+    static TACOperand temp(uint32_t index) { return make(TEMP, index); }
+    static TACOperand variable(uint32_t index) { return make(VARIABLE, index); }
+    static TACOperand constant(uint32_t index) { return make(CONSTANT, index); }
+    static TACOperand label(uint32_t index) { return make(LABEL, index); }
+
+    bool none() const { return bits == NONE_BITS; }
+    Kind kind() const { return static_cast<Kind>(bits >> INDEX_BITS); }
+    uint32_t index() const { return bits & INDEX_MASK; }
+    bool is(Kind k) const { return !none() && kind() == k; }
+
+    bool operator==(TACOperand other) const { return bits == other.bits; }
+    bool operator!=(TACOperand other) const { return bits != other.bits; }
+};
+
+struct TACInstruction {
+    TACOp op;
+    ValueType type;           // of the operands; element type for LOAD/STORE
+    TACCondition condition;   // IF, IF_FALSE only
+    uint8_t unused;
+    TACOperand result;        // destination, array for STORE, label for LABEL/JUMP/IF
+    TACOperand a;
+    TACOperand b;
+
+    TACInstruction(TACOp op, ValueType type, TACOperand result, TACOperand a = TACOperand(),
+                   TACOperand b = TACOperand(), TACCondition condition = TACCondition::TRUTH)
+        : op(op), type(type), condition(condition), unused(0), result(result), a(a), b(b) {}
+
+    bool isJump() const { return op == TACOp::JUMP || op == TACOp::IF || op == TACOp::IF_FALSE; }
+};
+
+static_assert(sizeof(TACInstruction) == 16, "TAC instructions should stay 16 bytes");
+
+struct TACConstant {
+    ValueType type;   // INT or FLOAT
+    Symbol text;      // as written, for printing
+    int64_t integer;
+    double real;
+};
+
+struct TACVariable {
+    Symbol name;                     // unique: shadowed names get their symbol ID, a.3
+    ValueType type;                  // element type for arrays
+    std::vector<int64_t> dimensions; // empty for scalars
+};
+
+// A lowered program with the tables its operands index
+struct TACProgram {
+    std::vector<TACInstruction> code;
+    std::vector<TACVariable> variables;  // by symbol ID
+    std::vector<TACConstant> constants;
+    std::vector<ValueType> temps;        // type of each temp
+    uint32_t labelCount = 0;
+
+    std::string operandText(TACOperand operand) const {
+        if (operand.none()) return "_";
+        switch (operand.kind()) {
+            case TACOperand::TEMP: return "t" + std::to_string(operand.index() + 1);
+            case TACOperand::VARIABLE: return std::string(symbolText(variables[operand.index()].name));
+            case TACOperand::CONSTANT: return std::string(symbolText(constants[operand.index()].text));
+            default: return "L" + std::to_string(operand.index() + 1);
+        }
+    }
+
+    // One line per instruction, labels flush left
+    void print(std::ostream& out, const TACInstruction& in) const {
+        if (in.op == TACOp::LABEL) {
+            out << operandText(in.result) << ":" << std::endl;
+            return;
+        }
+        out << "    ";
+        switch (in.op) {
+            case TACOp::JUMP:
+                out << "goto " << operandText(in.result);
+                break;
+            case TACOp::RETURN:
+                out << "return " << operandText(in.a);
+                break;
+            case TACOp::COPY:
+                out << operandText(in.result) << " = " << operandText(in.a);
+                break;
+            case TACOp::LOAD:
+                out << operandText(in.result) << " = " << operandText(in.a) << "[" << operandText(in.b) << "]";
+                break;
+            case TACOp::STORE:
+                out << operandText(in.result) << "[" << operandText(in.a) << "] = " << operandText(in.b);
+                break;
+            case TACOp::IF:
+            case TACOp::IF_FALSE:
+                out << tacOpText(in.op) << " " << operandText(in.a);
+                if (in.condition != TACCondition::TRUTH) {
+                    out << " " << tacConditionText(in.condition) << " " << operandText(in.b);
+                }
+                out << " goto " << operandText(in.result);
+                break;
+            case TACOp::NEG:
+            case TACOp::NOT:
+            case TACOp::TO_FLOAT:
+            case TACOp::TO_INT:
+            case TACOp::TO_CHAR:
+                out << operandText(in.result) << " = " << tacOpText(in.op) << " " << operandText(in.a);
+                break;
+            default:
+                out << operandText(in.result) << " = " << operandText(in.a) << " " << tacOpText(in.op) << " "
+                    << operandText(in.b);
+                break;
+        }
+        out << std::endl;
+    }
+
+    void print(std::ostream& out) const {
+        for (const TACInstruction& in : code) {
+            print(out, in);
+        }
+    }
+};
+
+#endif
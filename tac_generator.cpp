@@ -1,220 +1,554 @@
-#include <iostream>
-#include <vector>
-#include <string>
-using namespace std;
-
-// Class for a TAC instruction (think of it like a line of code)
-class TACInstruction {
-public:
-    string op;        // Operator, like "+", "-", etc.
-    string result;    // Result, like t1, x, etc.
-    string operand1;  // Operand 1, like x, 5, etc.
-    string operand2;  // Operand 2 (optional)
-
-    TACInstruction(string op, string result, string operand1, string operand2 = "")
-        : op(op), result(result), operand1(operand1), operand2(operand2) {}
-
-    // Prints the TAC instruction nicely
-    void print() const {
-        if (operand2.empty())
-            cout << result << " = " << operand1 << " " << op << endl;
-        else
-            cout << result << " = " << operand1 << " " << op << " " << operand2 << endl;
-    }
-};
-
-// Class to generate TAC instructions
-class TACGenerator {
-private:
-    int tempVarCount; // Counter for generating temporary vars (t1, t2, etc.)
-    int labelCount;   // Counter for generating unique labels (L1, L2, etc.)
-    vector<TACInstruction> instructions; // All TAC instructions we generate
-
-    // Helper method to create temporary variables like t1, t2, t3
-    string generateTempVar() {
-        return "t" + to_string(tempVarCount++);
-    }
-
-    // Helper method to generate unique labels like L1, L2
-    string generateLabel() {
-        return "L" + to_string(labelCount++);
-    }
-
-public:
-    TACGenerator() : tempVarCount(1), labelCount(1) {}
-
-    // Generate TAC for expressions like t1 = x + y
-    void generateTACForExpression(string op, string operand1, string operand2) {
-        string result = generateTempVar(); // Create a new temporary variable
-        TACInstruction instr(op, result, operand1, operand2); // Create the TAC instruction
-        instructions.push_back(instr); // Save it
-    }
-
-    // Generate TAC for unary expressions like t1 = -x
-    void generateTACForUnaryExpression(string op, string operand) {
-        string result = generateTempVar();
-        TACInstruction instr(op, result, operand); // Create the TAC instruction
-        instructions.push_back(instr);
-    }
-
-    // Generate TAC for assignments like x = t1
-    void generateTACForAssignment(string var, string expr) {
-        TACInstruction instr("=", var, expr); // Create the assignment instruction
-        instructions.push_back(instr);
-    }
-
-    // Generate TAC for if statement (if condition goto label)
-    void generateTACForIf(string condition, string label) {
-        TACInstruction instr("if", condition, label); // If condition is true, jump to label
-        instructions.push_back(instr);
-    }
-
-    // Generate TAC for while loop (while condition goto label)
-    void generateTACForWhile(string condition, string label) {
-        TACInstruction instr("while", condition, label); // While condition is true, jump to label
-        instructions.push_back(instr);
-    }
-
-    // Generate TAC for return statement like return t1
-    void generateTACForReturn(string expr) {
-        TACInstruction instr("return", expr, ""); // Just return the expression
-        instructions.push_back(instr);
-    }
-
-    // Traverse the AST and generate TAC for each node
-    void generateTACForAST(ASTNode* astNode) {
-        if (astNode == nullptr) return;
-
-        // Handle different node types like "Program", "Statement", etc.
-        if (astNode->nodeType == "Program") {
-            for (auto* child : astNode->children) {
-                generateTACForAST(child); // Handle all the program's children (e.g., functions)
-            }
-        }
-        else if (astNode->nodeType == "Block") {
-            for (auto* child : astNode->children) {
-                generateTACForAST(child); // Handle all block statements (like declarations and assignments)
-            }
-        }
-        else if (astNode->nodeType == "Declaration") {
-            // Declarations don't generate TAC, but they affect symbol table
-        }
-        else if (astNode->nodeType == "Statement") {
-            if (astNode->children.size() == 1) {
-                // Handle assignment (e.g., t1 = x + y)
-                string var = astNode->children[0]->value;
-                string expr = astNode->children[1]->value;
-                generateTACForAssignment(var, expr);
-            }
-            else if (astNode->children.size() == 2) {
-                // Handle control flow: if and while statements
-                string condition = astNode->children[0]->value;
-                string label = astNode->children[1]->value;
-                if (condition == "if") {
-                    generateTACForIf(condition, label);
-                } else if (condition == "while") {
-                    generateTACForWhile(condition, label);
-                }
-            }
-        }
-        else if (astNode->nodeType == "Expression") {
-            string op = astNode->value;
-            if (astNode->children.size() == 2) {
-                // Binary expression (e.g., t1 = x + y)
-                string operand1 = astNode->children[0]->value;
-                string operand2 = astNode->children[1]->value;
-                generateTACForExpression(op, operand1, operand2);
-            } else if (astNode->children.size() == 1) {
-                // Unary expression (e.g., t1 = -x)
-                string operand = astNode->children[0]->value;
-                generateTACForUnaryExpression(op, operand);
-            }
-        }
-    }
-
-    // Print out all TAC instructions (so we know what was generated)
-    void printTAC() const {
-        for (const auto& instr : instructions) {
-            instr.print();
-        }
-    }
-};
-
-// Simple class to represent AST nodes (abstract syntax tree)
-class ASTNode {
-public:
-    string nodeType; // Type of node (e.g., "Program", "Statement", "Expression")
-    string value;    // Value of the node (e.g., "x", "+", etc.)
-    vector<ASTNode*> children; // Child nodes (sub-expressions or sub-statements)
-
-    ASTNode(string type) : nodeType(type) {}
-    ASTNode(string type, string val) : nodeType(type), value(val) {}
-
-    void addChild(ASTNode* child) {
-        if (child != nullptr) {
-            children.push_back(child);
-        }
-    }
-
-    void printTree(int depth = 0) const {
-        string indent(depth * 2, ' ');
-        cout << indent << nodeType;
-        if (!value.empty()) {
-            cout << " (" << value << ")";
-        }
-        cout << endl;
-        for (auto* child : children) {
-            if (child != nullptr) {
-                child->printTree(depth + 1);
-            }
-        }
-    }
-
-    ~ASTNode() {
-        for (auto* child : children) {
-            delete child;
-        }
-    }
-};
-
-int main() {
-    // Create a sample AST for the second test case
-    ASTNode* programNode = new ASTNode("Program");
-
-    // Add a block for the main function
-    ASTNode* blockNode = new ASTNode("Block");
-    programNode->addChild(blockNode);
-
-    // Example: x = a + b
-    ASTNode* assignmentNode = new ASTNode("Statement");
-    ASTNode* varNode = new ASTNode("Identifier", "x");
-    ASTNode* exprNode = new ASTNode("Expression", "+");
-    exprNode->addChild(new ASTNode("Identifier", "a"));
-    exprNode->addChild(new ASTNode("Identifier", "b"));
-    assignmentNode->addChild(varNode);
-    assignmentNode->addChild(exprNode);
-    blockNode->addChild(assignmentNode);
-
-    // Example: if (x < 10) goto L1
-    ASTNode* ifNode = new ASTNode("Statement");
-    ASTNode* conditionNode = new ASTNode("Expression", "<");
-    conditionNode->addChild(new ASTNode("Identifier", "x"));
-    conditionNode->addChild(new ASTNode("Integer", "10"));
-    ifNode->addChild(new ASTNode("if"));
-    ifNode->addChild(conditionNode);
-    ifNode->addChild(new ASTNode("L1")); // Label for if block
-    blockNode->addChild(ifNode);
-
-    // Instantiate the TAC generator
-    TACGenerator tacGen;
-    tacGen.generateTACForAST(programNode);
-
-    // Print out the TAC instructions we generated
-    cout << "Generated TAC:" << endl;
-    tacGen.printTAC();
-
-    // Clean up memory
-    delete programNode;
-
-    return 0;
-}
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#define SEMANTIC_PHASE_3_NO_MAIN
+#include "semantic_phase_3.cpp"
+#include "tac.h"
+using namespace std;
+
+// Class to generate TAC instructions from a resolved AST (see
+// SemanticAnalyzer::resolve). Conditions become jumping code, so && and
+// || short-circuit and an if or loop tests its condition with a branch
+// instead of a 0/1 value. Like the parser, the lowering keeps its own work
+// stack instead of recursing, so deep programs are fine.
+class TACGenerator {
+private:
+    TACProgram program;
+    const SemanticInfo& info;
+    unordered_map<Symbol, uint32_t> constantIndex; // literal text -> constant
+
+    // A computed value: a variable, a constant or a temp
+    struct Value {
+        TACOperand operand;
+        ValueType type;
+    };
+
+    // What's left to do. Steps run last-in first-out; schedule() takes
+    // them in the order they should run.
+    enum class Step : uint8_t {
+        STATEMENT,   // lower node
+        VALUE,       // push node's value
+        OPERATOR,    // pop operands, apply node's operator, push the result
+        SUBSCRIPT,   // pop subscript and offset so far, push offset * dimension + subscript
+        LOAD,        // pop the element offset of node, push the element
+        STORE,       // pop the value (and element offset) for Assign node
+        BRANCH,      // jump to whenTrue/whenFalse on node; none falls through
+        TEST,        // pop one value, or two for relational node, and branch
+        LABEL,       // whenTrue:
+        JUMP,        // goto whenTrue
+        SET,         // whenTrue = whenFalse
+        PUSH,        // push temp whenTrue (an int)
+        ENTER_LOOP,  // break now goes to whenTrue
+        EXIT_LOOP
+    };
+    struct Work {
+        Step step;
+        ASTNode* node;
+        TACOperand whenTrue;
+        TACOperand whenFalse;
+    };
+    vector<Work> work;
+    vector<Value> values;
+    vector<TACOperand> loopExits;
+
+    static Work step(Step what, ASTNode* node, TACOperand whenTrue = TACOperand(),
+                     TACOperand whenFalse = TACOperand()) {
+        return Work{what, node, whenTrue, whenFalse};
+    }
+
+    void schedule(const vector<Work>& steps) {
+        for (size_t i = steps.size(); i-- > 0;) {
+            work.push_back(steps[i]);
+        }
+    }
+
+    // Helper method to create temporary variables like t1, t2, t3
+    TACOperand generateTempVar(ValueType type) {
+        program.temps.push_back(type);
+        return TACOperand::temp((uint32_t)program.temps.size() - 1);
+    }
+
+    // Helper method to generate unique labels like L1, L2
+    TACOperand generateLabel() {
+        return TACOperand::label(program.labelCount++);
+    }
+
+    // Literals are stored once each
+    TACOperand constant(Symbol text, ValueType type) {
+        auto found = constantIndex.find(text);
+        if (found != constantIndex.end()) return TACOperand::constant(found->second);
+        string digits(symbolText(text));
+        TACConstant value{type, text, strtoll(digits.c_str(), nullptr, 10), strtod(digits.c_str(), nullptr)};
+        program.constants.push_back(value);
+        constantIndex[text] = (uint32_t)program.constants.size() - 1;
+        return TACOperand::constant((uint32_t)program.constants.size() - 1);
+    }
+
+    TACOperand constant(int64_t number) {
+        return constant(intern(to_string(number)), ValueType::INT);
+    }
+
+    void emit(TACOp op, ValueType type, TACOperand result, TACOperand a = TACOperand(), TACOperand b = TACOperand(),
+              TACCondition condition = TACCondition::TRUTH) {
+        program.code.push_back(TACInstruction(op, type, result, a, b, condition));
+    }
+
+    Value pop() {
+        Value value = values.back();
+        values.pop_back();
+        return value;
+    }
+
+    // Value in type to. char widens to int for free, everything else
+    // takes a cast.
+    Value convert(Value value, ValueType to) {
+        if (value.type == to || (value.type == ValueType::CHAR && to == ValueType::INT)) {
+            return value;
+        }
+        TACOp cast = to == ValueType::FLOAT ? TACOp::TO_FLOAT : to == ValueType::CHAR ? TACOp::TO_CHAR : TACOp::TO_INT;
+        TACOperand temp = generateTempVar(to);
+        emit(cast, value.type, temp, value.operand);
+        return Value{temp, to};
+    }
+
+    static ValueType common(const Value& a, const Value& b) {
+        return a.type == ValueType::FLOAT || b.type == ValueType::FLOAT ? ValueType::FLOAT : ValueType::INT;
+    }
+
+    static bool isRelational(BinaryOp op) {
+        return op >= BinaryOp::EQUAL && op <= BinaryOp::GREATER_EQ;
+    }
+
+    static TACOp binaryTACOp(BinaryOp op) {
+        switch (op) {
+            case BinaryOp::EQUAL: return TACOp::EQ;
+            case BinaryOp::NOT_EQUAL: return TACOp::NE;
+            case BinaryOp::LESS: return TACOp::LT;
+            case BinaryOp::LESS_EQ: return TACOp::LE;
+            case BinaryOp::GREATER: return TACOp::GT;
+            case BinaryOp::GREATER_EQ: return TACOp::GE;
+            case BinaryOp::ADD: return TACOp::ADD;
+            case BinaryOp::SUBTRACT: return TACOp::SUB;
+            case BinaryOp::MULTIPLY: return TACOp::MUL;
+            default: return TACOp::DIV;
+        }
+    }
+
+    static TACCondition condition(BinaryOp op) {
+        switch (op) {
+            case BinaryOp::EQUAL: return TACCondition::EQ;
+            case BinaryOp::NOT_EQUAL: return TACCondition::NE;
+            case BinaryOp::LESS: return TACCondition::LT;
+            case BinaryOp::LESS_EQ: return TACCondition::LE;
+            case BinaryOp::GREATER: return TACCondition::GT;
+            default: return TACCondition::GE;
+        }
+    }
+
+    static int64_t elementWidth(ValueType type) {
+        switch (type) {
+            case ValueType::FLOAT: return 8;
+            case ValueType::CHAR: return 1;
+            default: return 4;
+        }
+    }
+
+    const SymbolInfo& symbolOf(const ASTNode* node) const {
+        return info.symbols[info.symbolOf[node->id]];
+    }
+
+    TACOperand variableOf(const ASTNode* node) const {
+        return TACOperand::variable((uint32_t)info.symbolOf[node->id]);
+    }
+
+    // Row-major offset of a[i][j]..., one SUBSCRIPT step per dimension past
+    // the first: ((i * d1) + j) * d2 + k ...
+    vector<Work> addressSteps(ASTNode* outer) {
+        vector<ASTNode*> chain; // innermost Index first
+        for (ASTNode* node = outer; node->kind == ASTKind::INDEX; node = astCast<IndexNode>(node)->base()) {
+            chain.push_back(node);
+        }
+        vector<Work> steps;
+        for (size_t k = chain.size(); k-- > 0;) {
+            steps.push_back(step(Step::VALUE, astCast<IndexNode>(chain[k])->subscript()));
+            if (k + 1 < chain.size()) {
+                steps.push_back(step(Step::SUBSCRIPT, chain[k]));
+            }
+        }
+        return steps;
+    }
+
+    Value byteOffset(ASTNode* index) {
+        Value offset = pop();
+        int64_t width = elementWidth(symbolOf(index).type);
+        if (width == 1) return offset;
+        TACOperand temp = generateTempVar(ValueType::INT);
+        emit(TACOp::MUL, ValueType::INT, temp, offset.operand, constant(width));
+        return Value{temp, ValueType::INT};
+    }
+
+    void lowerStatement(ASTNode* node) {
+        switch (node->kind) {
+            case ASTKind::PROGRAM:
+                schedule({step(Step::STATEMENT, astCast<ProgramNode>(node)->block())});
+                break;
+
+            case ASTKind::BLOCK:
+                for (size_t i = node->children.size(); i-- > 0;) {
+                    ASTNode* item = node->children[i];
+                    if (item->kind != ASTKind::DECLARATION) {
+                        work.push_back(step(Step::STATEMENT, item));
+                    }
+                }
+                break;
+
+            case ASTKind::ASSIGN: {
+                AssignNode* assign = astCast<AssignNode>(node);
+                vector<Work> steps = {step(Step::VALUE, assign->expression())};
+                if (assign->target()->kind == ASTKind::INDEX) {
+                    vector<Work> address = addressSteps(assign->target());
+                    steps.insert(steps.end(), address.begin(), address.end());
+                }
+                steps.push_back(step(Step::STORE, assign));
+                schedule(steps);
+                break;
+            }
+
+            case ASTKind::IF: {
+                IfNode* ifNode = astCast<IfNode>(node);
+                TACOperand end = generateLabel();
+                if (!ifNode->elseStmt()) {
+                    schedule({step(Step::BRANCH, ifNode->condition(), TACOperand(), end),
+                              step(Step::STATEMENT, ifNode->thenStmt()),
+                              step(Step::LABEL, nullptr, end)});
+                } else {
+                    TACOperand elseLabel = generateLabel();
+                    schedule({step(Step::BRANCH, ifNode->condition(), TACOperand(), elseLabel),
+                              step(Step::STATEMENT, ifNode->thenStmt()),
+                              step(Step::JUMP, nullptr, end),
+                              step(Step::LABEL, nullptr, elseLabel),
+                              step(Step::STATEMENT, ifNode->elseStmt()),
+                              step(Step::LABEL, nullptr, end)});
+                }
+                break;
+            }
+
+            case ASTKind::WHILE: {
+                WhileNode* loop = astCast<WhileNode>(node);
+                TACOperand begin = generateLabel();
+                TACOperand end = generateLabel();
+                schedule({step(Step::LABEL, nullptr, begin),
+                          step(Step::BRANCH, loop->condition(), TACOperand(), end),
+                          step(Step::ENTER_LOOP, nullptr, end),
+                          step(Step::STATEMENT, loop->body()),
+                          step(Step::EXIT_LOOP, nullptr),
+                          step(Step::JUMP, nullptr, begin),
+                          step(Step::LABEL, nullptr, end)});
+                break;
+            }
+
+            case ASTKind::DO_WHILE: {
+                DoWhileNode* loop = astCast<DoWhileNode>(node);
+                TACOperand begin = generateLabel();
+                TACOperand end = generateLabel();
+                schedule({step(Step::LABEL, nullptr, begin),
+                          step(Step::ENTER_LOOP, nullptr, end),
+                          step(Step::STATEMENT, loop->body()),
+                          step(Step::EXIT_LOOP, nullptr),
+                          step(Step::BRANCH, loop->condition(), begin, TACOperand()),
+                          step(Step::LABEL, nullptr, end)});
+                break;
+            }
+
+            case ASTKind::RETURN:
+                emit(TACOp::RETURN, ValueType::INT, TACOperand(),
+                     constant(astCast<ReturnNode>(node)->expression()->value, ValueType::INT));
+                break;
+
+            case ASTKind::BREAK:
+                emit(TACOp::JUMP, ValueType::UNKNOWN, loopExits.back());
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void lowerValue(ASTNode* node) {
+        switch (node->kind) {
+            case ASTKind::IDENTIFIER:
+                values.push_back(Value{variableOf(node), info.typeOf[node->id]});
+                break;
+
+            case ASTKind::INTEGER:
+            case ASTKind::REAL:
+                values.push_back(Value{constant(node->value, info.typeOf[node->id]), info.typeOf[node->id]});
+                break;
+
+            case ASTKind::INDEX: {
+                vector<Work> steps = addressSteps(node);
+                steps.push_back(step(Step::LOAD, node));
+                schedule(steps);
+                break;
+            }
+
+            case ASTKind::BINARY_OP: {
+                BinaryOpNode* binary = astCast<BinaryOpNode>(node);
+                if (binary->op == BinaryOp::AND || binary->op == BinaryOp::OR) {
+                    // As a value: t = 1, or t = 0 when the condition fails
+                    TACOperand temp = generateTempVar(ValueType::INT);
+                    TACOperand isFalse = generateLabel();
+                    TACOperand end = generateLabel();
+                    schedule({step(Step::BRANCH, node, TACOperand(), isFalse),
+                              step(Step::SET, nullptr, temp, constant(1)),
+                              step(Step::JUMP, nullptr, end),
+                              step(Step::LABEL, nullptr, isFalse),
+                              step(Step::SET, nullptr, temp, constant(0)),
+                              step(Step::LABEL, nullptr, end),
+                              step(Step::PUSH, nullptr, temp)});
+                } else {
+                    schedule({step(Step::VALUE, binary->left()), step(Step::VALUE, binary->right()),
+                              step(Step::OPERATOR, node)});
+                }
+                break;
+            }
+
+            case ASTKind::UNARY_OP:
+                schedule({step(Step::VALUE, astCast<UnaryOpNode>(node)->operand()), step(Step::OPERATOR, node)});
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void applyOperator(ASTNode* node) {
+        ValueType type = info.typeOf[node->id];
+        if (node->kind == ASTKind::UNARY_OP) {
+            Value operand = pop();
+            TACOperand temp = generateTempVar(type);
+            TACOp op = astCast<UnaryOpNode>(node)->op == UnaryOp::NOT ? TACOp::NOT : TACOp::NEG;
+            emit(op, operand.type, temp, operand.operand);
+            values.push_back(Value{temp, type});
+            return;
+        }
+        Value right = pop();
+        Value left = pop();
+        ValueType operands = common(left, right);
+        left = convert(left, operands);
+        right = convert(right, operands);
+        TACOperand temp = generateTempVar(type);
+        emit(binaryTACOp(astCast<BinaryOpNode>(node)->op), operands, temp, left.operand, right.operand);
+        values.push_back(Value{temp, type});
+    }
+
+    void store(AssignNode* assign) {
+        ASTNode* target = assign->target();
+        ValueType type = symbolOf(target).type;
+        TACOperand variable = variableOf(target);
+        if (target->kind == ASTKind::INDEX) {
+            Value offset = byteOffset(target);
+            Value value = convert(pop(), type);
+            emit(TACOp::STORE, type, variable, offset.operand, value.operand);
+            return;
+        }
+        Value value = convert(pop(), type);
+        // t = a + b; x = t  is just  x = a + b
+        if (value.operand.is(TACOperand::TEMP) && !program.code.empty() && program.code.back().result == value.operand) {
+            program.code.back().result = variable;
+            if (value.operand.index() + 1 == program.temps.size()) program.temps.pop_back();
+            return;
+        }
+        emit(TACOp::COPY, type, variable, value.operand);
+    }
+
+    // Jumping code for a condition, whenTrue or whenFalse may fall through
+    void branch(ASTNode* node, TACOperand whenTrue, TACOperand whenFalse) {
+        if (node->kind == ASTKind::BINARY_OP) {
+            BinaryOpNode* binary = astCast<BinaryOpNode>(node);
+            if (binary->op == BinaryOp::AND) {
+                TACOperand isFalse = whenFalse.none() ? generateLabel() : whenFalse;
+                vector<Work> steps = {step(Step::BRANCH, binary->left(), TACOperand(), isFalse),
+                                      step(Step::BRANCH, binary->right(), whenTrue, whenFalse)};
+                if (whenFalse.none()) steps.push_back(step(Step::LABEL, nullptr, isFalse));
+                schedule(steps);
+                return;
+            }
+            if (binary->op == BinaryOp::OR) {
+                TACOperand isTrue = whenTrue.none() ? generateLabel() : whenTrue;
+                vector<Work> steps = {step(Step::BRANCH, binary->left(), isTrue, TACOperand()),
+                                      step(Step::BRANCH, binary->right(), whenTrue, whenFalse)};
+                if (whenTrue.none()) steps.push_back(step(Step::LABEL, nullptr, isTrue));
+                schedule(steps);
+                return;
+            }
+            if (isRelational(binary->op)) {
+                schedule({step(Step::VALUE, binary->left()), step(Step::VALUE, binary->right()),
+                          step(Step::TEST, node, whenTrue, whenFalse)});
+                return;
+            }
+        }
+        if (node->kind == ASTKind::UNARY_OP && astCast<UnaryOpNode>(node)->op == UnaryOp::NOT) {
+            schedule({step(Step::BRANCH, astCast<UnaryOpNode>(node)->operand(), whenFalse, whenTrue)});
+            return;
+        }
+        schedule({step(Step::VALUE, node), step(Step::TEST, nullptr, whenTrue, whenFalse)});
+    }
+
+    void test(ASTNode* relational, TACOperand whenTrue, TACOperand whenFalse) {
+        Value left;
+        Value right{TACOperand(), ValueType::UNKNOWN};
+        TACCondition test = TACCondition::TRUTH;
+        if (relational) {
+            right = pop();
+            left = pop();
+            ValueType operands = common(left, right);
+            left = convert(left, operands);
+            right = convert(right, operands);
+            test = condition(astCast<BinaryOpNode>(relational)->op);
+        } else {
+            left = pop();
+        }
+        if (!whenTrue.none()) {
+            emit(TACOp::IF, left.type, whenTrue, left.operand, right.operand, test);
+            if (!whenFalse.none()) emit(TACOp::JUMP, ValueType::UNKNOWN, whenFalse);
+        } else {
+            emit(TACOp::IF_FALSE, left.type, whenFalse, left.operand, right.operand, test);
+        }
+    }
+
+public:
+    explicit TACGenerator(const SemanticInfo& semanticInfo) : info(semanticInfo) {
+        // Variables are indexed by symbol ID. Shadowed or repeated names
+        // get the ID too: a, a.3
+        unordered_map<Symbol, bool> taken;
+        for (size_t id = 0; id < info.symbols.size(); id++) {
+            const SymbolInfo& symbol = info.symbols[id];
+            Symbol name = symbol.name;
+            if (taken[name]) {
+                name = intern(string(symbolText(name)) + "." + to_string(id));
+            }
+            taken[name] = true;
+            program.variables.push_back(TACVariable{name, symbol.type, symbol.dimensions});
+        }
+    }
+
+    // Lower the whole program, which must have been resolved without errors
+    void generateTACForAST(ASTNode* astNode) {
+        if (astNode == nullptr) return;
+        work.push_back(step(Step::STATEMENT, astNode));
+        while (!work.empty()) {
+            Work next = work.back();
+            work.pop_back();
+            switch (next.step) {
+                case Step::STATEMENT: lowerStatement(next.node); break;
+                case Step::VALUE: lowerValue(next.node); break;
+                case Step::OPERATOR: applyOperator(next.node); break;
+                case Step::SUBSCRIPT: {
+                    Value subscript = pop();
+                    Value offset = pop();
+                    const SymbolInfo& array = symbolOf(next.node);
+                    size_t dimension = array.dimensions.size() - 1 - info.rankOf[next.node->id];
+                    TACOperand scaled = generateTempVar(ValueType::INT);
+                    emit(TACOp::MUL, ValueType::INT, scaled, offset.operand, constant(array.dimensions[dimension]));
+                    TACOperand sum = generateTempVar(ValueType::INT);
+                    emit(TACOp::ADD, ValueType::INT, sum, scaled, subscript.operand);
+                    values.push_back(Value{sum, ValueType::INT});
+                    break;
+                }
+                case Step::LOAD: {
+                    Value offset = byteOffset(next.node);
+                    ValueType type = info.typeOf[next.node->id];
+                    TACOperand temp = generateTempVar(type);
+                    emit(TACOp::LOAD, type, temp, variableOf(next.node), offset.operand);
+                    values.push_back(Value{temp, type});
+                    break;
+                }
+                case Step::STORE: store(astCast<AssignNode>(next.node)); break;
+                case Step::BRANCH: branch(next.node, next.whenTrue, next.whenFalse); break;
+                case Step::TEST: test(next.node, next.whenTrue, next.whenFalse); break;
+                case Step::LABEL: emit(TACOp::LABEL, ValueType::UNKNOWN, next.whenTrue); break;
+                case Step::JUMP: emit(TACOp::JUMP, ValueType::UNKNOWN, next.whenTrue); break;
+                case Step::SET: emit(TACOp::COPY, ValueType::INT, next.whenTrue, next.whenFalse); break;
+                case Step::PUSH: values.push_back(Value{next.whenTrue, ValueType::INT}); break;
+                case Step::ENTER_LOOP: loopExits.push_back(next.whenTrue); break;
+                case Step::EXIT_LOOP: loopExits.pop_back(); break;
+            }
+        }
+    }
+
+    const TACProgram& getProgram() const { return program; }
+    TACProgram takeProgram() { return std::move(program); }
+
+    // Print out all TAC instructions (so we know what was generated)
+    void printTAC() const {
+        program.print(cout);
+    }
+};
+
+// Built-in sample for the drivers that take an optional file
+const char* const SAMPLE_PROGRAM = R"(
+    int main() {
+    int i; int sum; int[4][3] grid; float avg;
+    i = 0; sum = 0;
+    while (i < 4) {
+        grid[i][i - i] = i * 2;
+        if (i == 1 || grid[i][0] > 5 && !(sum == 0)) sum = sum + grid[i][0];
+        else { sum = sum - 1; }
+        i = i + 1;
+    }
+    do { i = i - 1; if (i < 2) break; } while (i > 0);
+    avg = sum / 4.0;
+    return 0;
+    }
+    )";
+
+// Front end and lowering for one source text. Problems go to the
+// diagnostics and leave program empty.
+bool compileToTAC(string_view source, TACProgram& program, Diagnostics& diagnostics) {
+    SymbolTable symbolTable;
+    Lexer lex(source);
+    Arena arena;
+    Parser parser(lex, source, symbolTable, arena, diagnostics);
+    ASTBuilder builder;
+    ASTNode* ast = parser.parseAST(builder);
+
+    SemanticAnalyzer analyzer(diagnostics);
+    if (!diagnostics.hasErrors()) {
+        analyzer.resolve(ast);
+    }
+    if (!diagnostics.hasErrors()) {
+        TACGenerator tacGen(analyzer.semanticInfo());
+        tacGen.generateTACForAST(ast);
+        program = tacGen.takeProgram();
+    }
+
+    // Clean up memory
+    delete ast;
+    return !diagnostics.hasErrors();
+}
+
+// basic_block.cpp includes this file for the lowering and has its own main
+#ifndef TAC_GENERATOR_NO_MAIN
+
+// Usage: tac_generator [file]. Without a file the built-in sample is used.
+int main(int argc, char* argv[]) {
+    SourceFile file;
+    if (argc > 1 && !file.open(argv[1])) return 1;
+    string_view source = argc > 1 ? file.text() : string_view(SAMPLE_PROGRAM);
+
+    Diagnostics diagnostics;
+    TACProgram program;
+    if (!compileToTAC(source, program, diagnostics)) {
+        diagnostics.print(cerr);
+        return 1;
+    }
+
+    // Print out the TAC instructions we generated
+    cout << "Generated TAC:" << endl;
+    program.print(cout);
+    return 0;
+}
+
+#endif
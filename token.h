@@ -0,0 +1,79 @@
+#ifndef TOKEN_H
+#define TOKEN_H
+
+#include <cstdint>
+#include <string_view>
+
+// Define token types
+enum TokenType : uint8_t {
+    KEYWORD, IDENTIFIER, COMMENT, INVALID,
+    LEFT_PAREN, RIGHT_PAREN, LEFT_BRACKET, RIGHT_BRACKET,
+    LEFT_BRACE, RIGHT_BRACE, DOT, SEMICOLON, COMMA,
+    PLUS, MINUS, MULTIPLY, DIVIDE, MODULUS, ASSIGNMENT,
+    INCREMENT, DECREMENT, LESS_THAN, LESS_THAN_EQ,
+    GREATER_THAN, GREATER_THAN_EQ, LOGIC_EQUAL,
+    LOGIC_AND, LOGIC_OR, LOGIC_NOT, BIT_AND, BIT_OR, LOGIC_NOT_EQUAL,
+    BASIC, INTEGER, REAL, // update basic  phase 2
+    IF, ELSE, WHILE, BREAK, MAIN, DO, // update token phase 2
+    RETURN // add RETURN token
+};
+
+// Enum name of a token type, e.g. "IDENTIFIER"
+inline const char* tokenTypeName(TokenType type) {
+    static const char* const names[] = {
+        "KEYWORD", "IDENTIFIER", "COMMENT", "INVALID",
+        "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACKET", "RIGHT_BRACKET",
+        "LEFT_BRACE", "RIGHT_BRACE", "DOT", "SEMICOLON", "COMMA",
+        "PLUS", "MINUS", "MULTIPLY", "DIVIDE", "MODULUS", "ASSIGNMENT",
+        "INCREMENT", "DECREMENT", "LESS_THAN", "LESS_THAN_EQ",
+        "GREATER_THAN", "GREATER_THAN_EQ", "LOGIC_EQUAL",
+        "LOGIC_AND", "LOGIC_OR", "LOGIC_NOT", "BIT_AND", "BIT_OR", "LOGIC_NOT_EQUAL",
+        "BASIC", "INTEGER", "REAL",
+        "IF", "ELSE", "WHILE", "BREAK", "MAIN", "DO",
+        "RETURN"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == RETURN + 1, "names out of sync with TokenType");
+    return names[type];
+}
+
+// Line and column share one 32-bit word: 20 bits of line, 12 bits of column.
+// Both saturate instead of wrapping, the offset is always exact.
+const uint32_t TOKEN_COLUMN_BITS = 12;
+const uint32_t TOKEN_MAX_COLUMN = (1u << TOKEN_COLUMN_BITS) - 1;
+const uint32_t TOKEN_MAX_LINE = (1u << (32 - TOKEN_COLUMN_BITS)) - 1;
+
+// A token is a span into the source buffer, the lexeme is never copied
+struct Token {
+    uint32_t offset;    // byte offset of the lexeme in the source
+    uint32_t length;    // lexeme length in bytes
+    uint32_t position;  // packed line/column, see packPosition()
+    TokenType type;
+
+    static uint32_t packPosition(uint32_t line, uint32_t column) {
+        if (line > TOKEN_MAX_LINE) line = TOKEN_MAX_LINE;
+        if (column > TOKEN_MAX_COLUMN) column = TOKEN_MAX_COLUMN;
+        return (line << TOKEN_COLUMN_BITS) | column;
+    }
+
+    Token() : offset(0), length(0), position(0), type(INVALID) {}
+    Token(TokenType type, uint32_t offset, uint32_t length, uint32_t line, uint32_t column)
+        : offset(offset), length(length), position(packPosition(line, column)), type(type) {}
+
+    uint32_t line() const { return position >> TOKEN_COLUMN_BITS; }
+    uint32_t column() const { return position & TOKEN_MAX_COLUMN; }
+
+    // The lexeme, valid as long as the source buffer is
+    std::string_view text(std::string_view source) const {
+        return source.substr(offset, length);
+    }
+
+    bool operator==(const Token& other) const {
+        return offset == other.offset && length == other.length &&
+               position == other.position && type == other.type;
+    }
+    bool operator!=(const Token& other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(Token) == 16, "Token should stay 16 bytes");
+
+#endif
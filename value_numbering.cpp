@@ -0,0 +1,378 @@
+#include "optimizer.h"
+#include <unordered_map>
+using namespace std;
+
+// ---------------------------------------------------------------------------
+// Value numbering. Every value gets a number, and so does every expression
+// over numbers: op, type and operand numbers hashed together, commutative
+// operands sorted and a > b turned around into b < a, so equal values get
+// equal numbers however they were spelled. A second instruction computing a
+// number that's already held somewhere is replaced by that holder.
+//
+// The table is scoped to the dominator tree (Briggs, Cooper and Simpson):
+// an entry made in a block is seen by every block it dominates and popped
+// when the walk leaves it. That is plain local value numbering inside one
+// block and global across them, with no SSA needed for what's stable:
+// constants, and temps, which are written once and in a block dominating
+// every read. Variables are not; their numbers only flow from a block into
+// a child that has no other predecessor, and at a join they start over.
+//
+// Entries whose holder is a variable die when it's written again. Array
+// loads are numbered too, with the array's own number standing for its
+// contents: a store gives the array a new number, and the stored value is
+// what a load from the same offset gives until then.
+// ---------------------------------------------------------------------------
+
+class ValueNumbering {
+    typedef uint32_t ValueNumber;
+
+    struct Expression {
+        TACOp op;
+        ValueType type;
+        ValueNumber a;
+        ValueNumber b;
+
+        bool operator==(const Expression& other) const {
+            return op == other.op && type == other.type && a == other.a && b == other.b;
+        }
+    };
+    struct ExpressionHash {
+        size_t operator()(const Expression& e) const {
+            uint64_t h = (uint64_t)e.op << 8 | (uint64_t)e.type;
+            h = h * 0x9E3779B97F4A7C15ull ^ e.a;
+            h = h * 0x9E3779B97F4A7C15ull ^ e.b;
+            return (size_t)(h ^ (h >> 29));
+        }
+    };
+    struct Available {
+        ValueNumber value;
+        TACOperand holder; // none: not in the table
+    };
+
+    // Undo records, popped when the walk leaves the block that made them
+    struct TableChange {
+        Expression key;
+        Available previous;
+    };
+    struct VariableChange {
+        uint32_t variable;
+        ValueNumber value;
+        uint32_t stamp;
+    };
+
+    TACProgram& program;
+    ConstantPool constants;
+    ControlFlowGraph cfg;
+
+    unordered_map<Expression, Available, ExpressionHash> table;
+    vector<TableChange> tableLog;
+
+    // Constants number themselves by canonical index, which fits in an
+    // operand's index bits; everything else counts up from FIRST_VALUE
+    ValueNumber nextValue;
+    vector<ValueNumber> tempValue;
+    vector<uint32_t> tempWrites;
+    vector<TACOperand> replacement; // temp -> what its reads become, none if kept
+
+    // A variable's number holds from the block stamped extendedStart down
+    vector<ValueNumber> variableValue;
+    vector<uint32_t> variableStamp;
+    vector<VariableChange> variableLog;
+    uint32_t stamp;
+    uint32_t extendedStart;
+
+    vector<bool> removed;
+    ValueNumberingStats stats;
+
+    static constexpr uint32_t NO_STAMP = 0;
+    static constexpr ValueNumber NO_VALUE = UINT32_MAX;
+    static constexpr ValueNumber FIRST_VALUE = 1u << TACOperand::INDEX_BITS;
+
+    bool singleWrite(TACOperand operand) const {
+        return operand.is(TACOperand::TEMP) && tempWrites[operand.index()] == 1;
+    }
+
+    ValueNumber fresh() { return nextValue++; }
+
+    void setVariable(uint32_t variable, ValueNumber value) {
+        variableLog.push_back(VariableChange{variable, variableValue[variable], variableStamp[variable]});
+        variableValue[variable] = value;
+        variableStamp[variable] = stamp;
+    }
+
+    ValueNumber valueOf(TACOperand operand) {
+        uint32_t index = operand.index();
+        switch (operand.kind()) {
+            case TACOperand::CONSTANT:
+                return constants.canonical(index);
+            case TACOperand::TEMP:
+                return singleWrite(operand) ? tempValue[index] : fresh();
+            default:
+                if (variableStamp[index] < extendedStart) setVariable(index, fresh());
+                return variableValue[index];
+        }
+    }
+
+    // Is the value still where the table says?
+    bool holds(const Available& available) {
+        if (available.holder.none()) return false;
+        if (!available.holder.is(TACOperand::VARIABLE)) return true;
+        return valueOf(available.holder) == available.value;
+    }
+
+    void remember(const Expression& key, ValueNumber value, TACOperand holder) {
+        if (holder.is(TACOperand::TEMP) && !singleWrite(holder)) return;
+        Available& slot = table[key];
+        tableLog.push_back(TableChange{key, slot});
+        slot = Available{value, holder};
+    }
+
+    void substitute(TACOperand& operand) {
+        if (operand.is(TACOperand::TEMP) && !replacement[operand.index()].none()) {
+            operand = replacement[operand.index()];
+        }
+    }
+
+    void define(TACOperand result, ValueNumber value) {
+        if (result.is(TACOperand::TEMP)) tempValue[result.index()] = value;
+        else setVariable(result.index(), value);
+    }
+
+    ValueType typeOf(TACOperand operand) const {
+        return operand.is(TACOperand::TEMP) ? program.temps[operand.index()] : program.variables[operand.index()].type;
+    }
+
+    static bool isCommutative(TACOp op) {
+        return op == TACOp::ADD || op == TACOp::MUL || op == TACOp::EQ || op == TACOp::NE;
+    }
+
+    static TACOp mirrored(TACOp op) {
+        switch (op) {
+            case TACOp::LT: return TACOp::GT;
+            case TACOp::LE: return TACOp::GE;
+            case TACOp::GT: return TACOp::LT;
+            case TACOp::GE: return TACOp::LE;
+            default: return op;
+        }
+    }
+
+    Expression expression(TACOp op, ValueType type, ValueNumber a, ValueNumber b) {
+        Expression key{op, type, a, b};
+        if (a > b && (isCommutative(op) || mirrored(op) != op)) {
+            swap(key.a, key.b);
+            key.op = mirrored(op);
+        }
+        return key;
+    }
+
+    static bool isConstant(ValueNumber value) { return value < FIRST_VALUE; }
+
+    TACOperand integer(int64_t number) { return TACOperand::constant(constants.integer(number)); }
+
+    // Integer identities: x + 0, x - 0, x * 1 and x / 1 are x, x * 0 and
+    // x - x are 0, and x compared with itself is decided. Floats are left
+    // alone for NaN and -0.0. Gives the operand holding the result, if any.
+    TACOperand simplify(const TACInstruction& in, ValueNumber a, ValueNumber b) {
+        if (in.type == ValueType::FLOAT || in.b.none() || in.op == TACOp::LOAD) return TACOperand();
+        auto is = [&](ValueNumber value, int64_t number) {
+            return isConstant(value) && constants[value].integer == number;
+        };
+        switch (in.op) {
+            case TACOp::ADD:
+                if (is(b, 0)) return in.a;
+                if (is(a, 0)) return in.b;
+                break;
+            case TACOp::SUB:
+                if (is(b, 0)) return in.a;
+                if (a == b) return integer(0);
+                break;
+            case TACOp::MUL:
+                if (is(b, 1)) return in.a;
+                if (is(a, 1)) return in.b;
+                if (is(a, 0) || is(b, 0)) return integer(0);
+                break;
+            case TACOp::DIV:
+                if (is(b, 1)) return in.a;
+                break;
+            case TACOp::EQ:
+            case TACOp::LE:
+            case TACOp::GE:
+                if (a == b) return integer(1);
+                break;
+            case TACOp::NE:
+            case TACOp::LT:
+            case TACOp::GT:
+                if (a == b) return integer(0);
+                break;
+            default:
+                break;
+        }
+        return TACOperand();
+    }
+
+    // result = op a b, or a load; reuse the value if it's held already
+    void number(uint32_t i) {
+        TACInstruction& in = program.code[i];
+        ValueNumber a = valueOf(in.a);
+        ValueNumber b = in.b.none() ? NO_VALUE : valueOf(in.b);
+        TACOperand same = simplify(in, a, b);
+        if (!same.none()) {
+            stats.simplified++;
+            reuse(i, same, valueOf(same));
+            return;
+        }
+
+        Expression key = expression(in.op, in.type, a, b);
+        auto found = table.find(key);
+        if (found == table.end() || !holds(found->second)) {
+            ValueNumber value = fresh();
+            define(in.result, value);
+            remember(key, value, in.result);
+            return;
+        }
+        if (in.op == TACOp::LOAD) stats.loads++;
+        else stats.redundant++;
+        reuse(i, found->second.holder, found->second.value);
+    }
+
+    // A temp result is renamed to a holder that can't change under it;
+    // anything else becomes a copy
+    void reuse(uint32_t i, TACOperand holder, ValueNumber value) {
+        TACOperand result = program.code[i].result;
+        if (singleWrite(result) && (holder.is(TACOperand::CONSTANT) || singleWrite(holder))) {
+            replacement[result.index()] = holder;
+            tempValue[result.index()] = value;
+            removed[i] = true;
+            return;
+        }
+        copy(i, holder, value);
+    }
+
+    // result = a, dropped when result holds that value already
+    void copy(uint32_t i, TACOperand from, ValueNumber value) {
+        TACInstruction& in = program.code[i];
+        if (in.result.is(TACOperand::VARIABLE) && valueOf(in.result) == value) {
+            removed[i] = true;
+            stats.copies++;
+            return;
+        }
+        if (in.op != TACOp::COPY) in = TACInstruction(TACOp::COPY, typeOf(in.result), in.result, from);
+        define(in.result, value);
+    }
+
+    void visit(BlockId b) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            TACInstruction& in = program.code[i];
+            substitute(in.a);
+            substitute(in.b);
+            switch (in.op) {
+                case TACOp::LABEL:
+                case TACOp::JUMP:
+                case TACOp::IF:
+                case TACOp::IF_FALSE:
+                case TACOp::RETURN:
+                    break;
+                case TACOp::COPY:
+                    copy(i, in.a, valueOf(in.a));
+                    break;
+                case TACOp::STORE: {
+                    ValueNumber offset = valueOf(in.a);
+                    ValueNumber stored = valueOf(in.b);
+                    ValueNumber contents = fresh();
+                    setVariable(in.result.index(), contents);
+                    remember(Expression{TACOp::LOAD, in.type, contents, offset}, stored, in.b);
+                    break;
+                }
+                default:
+                    number(i);
+                    break;
+            }
+        }
+    }
+
+    void undo(size_t tableMark, size_t variableMark) {
+        while (tableLog.size() > tableMark) {
+            const TableChange& change = tableLog.back();
+            table[change.key] = change.previous;
+            tableLog.pop_back();
+        }
+        while (variableLog.size() > variableMark) {
+            const VariableChange& change = variableLog.back();
+            variableValue[change.variable] = change.value;
+            variableStamp[change.variable] = change.stamp;
+            variableLog.pop_back();
+        }
+    }
+
+    // Dominator tree preorder on an explicit stack, undoing each block's
+    // entries on the way out
+    void walk() {
+        struct Frame {
+            BlockId block;
+            bool leaving;
+            size_t tableMark;
+            size_t variableMark;
+            uint32_t extendedStart;
+        };
+        vector<Frame> stack;
+        stack.push_back(Frame{0, false, 0, 0, 0});
+        while (!stack.empty()) {
+            Frame frame = stack.back();
+            stack.pop_back();
+            if (frame.leaving) {
+                undo(frame.tableMark, frame.variableMark);
+                extendedStart = frame.extendedStart;
+                continue;
+            }
+            BlockId b = frame.block;
+            stack.push_back(Frame{b, true, tableLog.size(), variableLog.size(), extendedStart});
+            stamp++;
+            if (b == 0 || cfg.predecessors(b).size() != 1) extendedStart = stamp;
+            visit(b);
+            BlockList children = cfg.dominatorChildren(b);
+            for (size_t c = children.size(); c-- > 0;) {
+                stack.push_back(Frame{children[c], false, 0, 0, 0});
+            }
+        }
+    }
+
+public:
+    explicit ValueNumbering(TACProgram& program)
+        : program(program), constants(program), cfg(program), stamp(NO_STAMP), extendedStart(NO_STAMP) {}
+
+    ValueNumberingStats run() {
+        if (cfg.size() == 0) return stats;
+        nextValue = FIRST_VALUE;
+        tempValue.assign(program.temps.size(), 0);
+        tempWrites.assign(program.temps.size(), 0);
+        replacement.assign(program.temps.size(), TACOperand());
+        variableValue.assign(program.variables.size(), 0);
+        variableStamp.assign(program.variables.size(), NO_STAMP);
+        removed.assign(program.code.size(), false);
+        for (const TACInstruction& in : program.code) {
+            if (in.result.is(TACOperand::TEMP)) tempWrites[in.result.index()]++;
+        }
+
+        walk();
+
+        // Blocks the walk never reached still read renamed temps
+        for (BlockId b = 0; b < cfg.size(); b++) {
+            if (cfg.reachable(b)) continue;
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                substitute(program.code[i].a);
+                substitute(program.code[i].b);
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < program.code.size(); i++) {
+            if (!removed[i]) program.code[kept++] = program.code[i];
+        }
+        program.code.erase(program.code.begin() + kept, program.code.end());
+        return stats;
+    }
+};
+
+ValueNumberingStats numberValues(TACProgram& program) {
+    return ValueNumbering(program).run();
+}